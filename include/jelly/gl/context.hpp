@@ -1,16 +1,29 @@
 #ifndef _JELLY_CONTEXT_HPP_
 #define _JELLY_CONTEXT_HPP_
 
-#include <map>
+#include <functional>
+#include <vector>
 
 #include <jelly/gl/framebuffer.hpp>
 #include <jelly/gl/mesh.hpp>
 #include <jelly/gl/shader.hpp>
+#include <jelly/gl/transient_buffer.hpp>
+#include <jelly/gl/uniform_buffer.hpp>
 
 namespace jelly {
 
+class Context;
 class Window;
 
+/**
+ * A flush callback function, used to submit deferred draws before the context
+ * state changes.
+ *
+ * \param Context
+ *     The context being flushed.
+ */
+typedef std::function<void(Context&)> flush_callback_t;
+
 class Context {
 
 public:
@@ -25,23 +38,93 @@ public:
      * Activates the given shader.
      *
      * All rendered meshes will be shaded using the given shader until another
-     * shader is applied.
+     * shader is applied. Deferred shaders are waited for when they are first
+     * activated.
+     *
+     * \throw std::runtime_error if a deferred shader failed to compile.
      */
     void activate_shader(Shader&);
 
     /**
-     * Renders the given mesh using the last applied shader.
+     * Renders a level of detail of the given mesh using the last applied
+     * shader, see Mesh::select_lod().
+     *
+     * \throw std::runtime_error if the mesh has no such level.
+     */
+    void render_mesh(const Mesh&, unsigned int lod = 0);
+
+    /**
+     * Renders many instances of a level of detail of the given mesh in a
+     * single draw, using the last applied shader. The per-instance data is
+     * copied to the transient buffer and read by the shader through instance
+     * attributes, which advance once per instance, e.g. a transform, a
+     * color and a material index read as an int:
+     *
+     *     VertexFormat format;
+     *     format.add_matrix(3, 4, 4)
+     *           .add(7, 4, VertexFormat::Type::UNSIGNED_BYTE, true)
+     *           .add_integer(8, 1, VertexFormat::Type::UNSIGNED_SHORT);
+     *
+     * \param mesh
+     *     The mesh to instance.
+     * \param format
+     *     The layout of the instances, with a single stream and locations
+     *     unused by the mesh.
+     * \param instances
+     *     The instance data, `count * format.get_stride(0)` bytes long.
+     * \param count
+     *     The number of instances.
+     * \param lod
+     *     The level of detail, see Mesh::select_lod().
+     *
+     * \throw std::runtime_error if the mesh has no such level, or if the
+     * format has several streams or a location used by the mesh.
      */
-    void render_mesh(const Mesh&);
+    void render_mesh_instanced(
+        const Mesh& mesh,
+        const VertexFormat& format,
+        const void* instances,
+        unsigned int count,
+        unsigned int lod = 0
+    );
 
     /**
-     * Binds a texture to one of the 16 available texture slots.
+     * Binds a texture to one of the 16 available texture slots. Binding a
+     * texture that is already bound to the slot has no effect.
      *
-     * \warning Certain texture operations such as creating a new texture or
-     * generating mipmaps may replace the last bound texture.
+     * \throw std::runtime_error if the slot exceeds the texture units of the
+     * driver.
      */
     void bind_texture(const Texture&, unsigned int index = 0);
 
+    /**
+     * Binds a uniform buffer to a uniform block binding point. Shaders read
+     * the buffer through blocks connected to the same binding point with
+     * Shader::set_uniform_block().
+     */
+    void bind_uniform_buffer(const UniformBuffer&, unsigned int binding);
+
+    /**
+     * Binds a range of the transient buffer to a uniform block binding point,
+     * e.g. a block written for a single draw. The offset of the range must be
+     * aligned to TransientBuffer::get_uniform_alignment().
+     */
+    void bind_uniform_range(const TransientRange&, unsigned int binding);
+
+    /**
+     * Copies the values of a uniform buffer to the transient buffer and binds
+     * them to a uniform block binding point. Blocks that change between draws
+     * are best streamed this way, as rewriting a buffer object still read by
+     * previous draws may stall.
+     */
+    void stream_uniform_buffer(const UniformBuffer&, unsigned int binding);
+
+    /**
+     * Returns the buffer for data written and drawn within the frame, see
+     * TransientBuffer.
+     */
+    TransientBuffer& get_transient_buffer() { return _transientBuffer; }
+
     /**
      * Clears the buffer to the given colour.
      */
@@ -50,10 +133,6 @@ public:
     /**
      * Uses the given framebuffer as the render target for subsequent rendering.
      *
-     * \warning Certain framebuffer operations such as creating a new
-     * framebuffer or attaching textures will replace the currently bound
-     * framebuffer.
-     *
      * \throw std::runtime_error if the framebuffer does not have the necessary
      * attachments or if the format of an attachment is incorrect.
      */
@@ -65,6 +144,84 @@ public:
      */
     void reset_framebuffer();
 
+    /**
+     * Enables or disables alpha blending. Enabled by default.
+     */
+    void set_blending(bool enabled);
+
+    /**
+     * Sets the source and destination blend factors, e.g. GL_SRC_ALPHA and
+     * GL_ONE_MINUS_SRC_ALPHA, which is the default.
+     */
+    void set_blend_func(unsigned int src, unsigned int dst);
+
+    /**
+     * Enables or disables depth testing. Disabled by default.
+     */
+    void set_depth_test(bool enabled);
+
+    /**
+     * Enables or disables writing to the depth buffer. Enabled by default.
+     */
+    void set_depth_write(bool enabled);
+
+    /**
+     * Enables or disables back face culling. Enabled by default.
+     */
+    void set_face_culling(bool enabled);
+
+    /**
+     * Enables or disables stencil testing. Enabled by default.
+     */
+    void set_stencil_test(bool enabled);
+
+    /**
+     * Enables or disables the scissor test. Disabled by default.
+     */
+    void set_scissor_test(bool enabled);
+
+    /**
+     * Sets the scissor rectangle in pixels, used when the scissor test is
+     * enabled.
+     */
+    void set_scissor(int x, int y, int width, int height);
+
+    /**
+     * Counts of the state changes requested from the context.
+     */
+    struct StateStats {
+
+        /**
+         * The number of state changes passed on to OpenGL.
+         */
+        unsigned int issued;
+
+        /**
+         * The number of state changes skipped because they would not have
+         * changed anything.
+         */
+        unsigned int elided;
+
+    };
+
+    /**
+     * Returns the state change counts of the previous frame.
+     */
+    StateStats get_state_stats() const { return _frameStats; }
+
+    /**
+     * Sets the callback function to be called whenever deferred draws must be
+     * submitted, i.e. before the context changes the active shader, binds
+     * textures or framebuffers, renders a mesh or clears the buffer.
+     */
+    void set_on_flush(flush_callback_t);
+
+    /**
+     * Submits all deferred draws by calling the flush callback. Calls made
+     * while the context is already flushing are ignored.
+     */
+    void flush();
+
     /**
      * Returns the window that owns this context.
      */
@@ -72,8 +229,22 @@ public:
 
 private:
 
+    friend class Framebuffer;
+    friend class Mesh;
+    friend class Shader;
+    friend class ShapeBatch;
+    friend class Texture;
+    friend class UniformBuffer;
     friend class Window;
 
+    /**
+     * The textures bound to a texture unit, one per target.
+     */
+    struct TextureUnit {
+        unsigned int texture2D;
+        unsigned int textureCube;
+    };
+
     Context(Window* owner);
 
     /**
@@ -81,12 +252,64 @@ private:
      */
     void _set_viewport(int width, int height);
 
+    void _use_program(unsigned int program);
+    void _bind_vertex_array(unsigned int vao);
+    void _bind_framebuffer(unsigned int fb);
+    void _set_active_texture(unsigned int index);
+    void _set_capability(unsigned int cap, bool& current, bool enabled);
+
+    /**
+     * Records the state change counts of the frame and resets them, and fences
+     * the transient data of the frame. Called by the window at the end of
+     * every frame.
+     */
+    void _end_frame();
+
+    /**
+     * Keeps the tracked state of the current context in sync with binds and
+     * deletions made by resources outside of it, e.g. while creating meshes
+     * and textures.
+     */
+    static void _notify_vertex_array(unsigned int vao);
+    static void _notify_texture(unsigned int target, unsigned int texture);
+    static void _notify_framebuffer(unsigned int fb);
+    static void _notify_deleted_vertex_array(unsigned int vao);
+    static void _notify_deleted_texture(unsigned int texture);
+    static void _notify_deleted_framebuffer(unsigned int fb);
+    static void _notify_deleted_buffer(unsigned int buffer);
+    static void _notify_deleted_shader(Shader* shader);
+
+    /**
+     * Returns the framebuffer bound by the current context, used by resources
+     * to restore it after binding their own.
+     */
+    static unsigned int _bound_framebuffer();
+
+    static Context* _current;
+
     Window* _owner;
 
+    flush_callback_t _flushCallback;
+    bool _flushing;
+
     Shader* _activeShader;
-    std::map<const Texture*, unsigned int> _boundTextures;
+    unsigned int _program;
+    unsigned int _vertexArray;
+    unsigned int _framebuffer;
+    unsigned int _activeTexture;
+    std::vector<TextureUnit> _textureUnits;
+    std::vector<unsigned int> _boundUniformBuffers;
+    TransientBuffer _transientBuffer;
     int _vpWidth, _vpHeight;
 
+    bool _blending, _depthTest, _depthWrite, _faceCulling, _stencilTest, _scissorTest;
+    unsigned int _blendSrc, _blendDst;
+    int _scissor[4];
+    Vec3 _clearColor;
+
+    StateStats _stats;
+    StateStats _frameStats;
+
 };
 
 }
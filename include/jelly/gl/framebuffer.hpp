@@ -80,9 +80,14 @@ private:
 
     friend class Context;
 
-    void _bind() const;
+    /**
+     * Updates the draw buffers and completeness of the bound framebuffer after
+     * an attachment changed, then rebinds the render target of the context.
+     */
+    void _update();
 
     unsigned int _handle;
+    bool _complete;
     std::vector<unsigned int> _usedColorBuffers;
     int _width, _height;
 
@@ -1,23 +1,50 @@
 #ifndef _JELLY_MESH_HPP_
 #define _JELLY_MESH_HPP_
 
+#include <cstdint>
 #include <vector>
 
 #include <GL/glew.h>
 
+#include <jelly/gl/mesh_optimizer.hpp>
+#include <jelly/gl/vertex_compression.hpp>
+#include <jelly/gl/vertex_format.hpp>
+#include <jelly/math/bounds.hpp>
+#include <jelly/math/mat4.hpp>
 #include <jelly/math/vec2.hpp>
 #include <jelly/math/vec3.hpp>
 
 namespace jelly {
 
 /**
- * Represents a renderable geometry mesh containing vertex, normal and uv-coord
- * buffers with an index array.
+ * Represents a renderable geometry mesh containing vertex buffers, laid out
+ * as described by a VertexFormat, with an index array.
  */
 class Mesh {
 
 public:
 
+    /**
+     * How often the buffers of a mesh are updated, a hint for the driver to
+     * place them in memory.
+     */
+    enum class Usage {
+        /**
+         * Uploaded once, the default.
+         */
+        STATIC = GL_STATIC_DRAW,
+
+        /**
+         * Updated now and then, and drawn many times in between.
+         */
+        DYNAMIC = GL_DYNAMIC_DRAW,
+
+        /**
+         * Updated about every frame.
+         */
+        STREAM = GL_STREAM_DRAW
+    };
+
     Mesh() = delete;
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
@@ -60,6 +87,66 @@ public:
      */
     static Mesh* sphere_mesh(unsigned int latRes=16, unsigned int lngRes=16, float radius=1.0f);
 
+    /**
+     * Creates a mesh with quantized vertices, which use less memory and
+     * bandwidth than the float vertices of the other constructors. Shaders
+     * must decode them as described by VertexCompression.
+     *
+     * \param vertices
+     *     The vector of vertices.
+     * \param normals
+     *     The vector of unit vertex normals, equal in length to `vertices`.
+     * \param uvs
+     *     The vector of UV/texture coordinates, equal in length to `vertices`.
+     * \param indices
+     *     The index array used for rendering primitives.
+     * \param compression
+     *     The encodings of the attributes.
+     * \param report
+     *     If not null, set to the errors of the encodings.
+     * \param mode
+     *     The OpenGL primitive mode used to render the vertices.
+     */
+    static Mesh* compressed_mesh(
+        const std::vector<Vec3>& vertices,
+        const std::vector<Vec3>& normals,
+        const std::vector<Vec2>& uvs,
+        const std::vector<unsigned int>& indices,
+        const VertexCompression& compression,
+        CompressionReport* report = nullptr,
+        unsigned int mode = GL_TRIANGLES
+    );
+
+    /**
+     * Creates a mesh with levels of detail, simplified from the given buffer
+     * arrays and sharing their vertices. The vertices and triangles are also
+     * reordered by MeshOptimizer.
+     *
+     * \param vertices
+     *     The vector of vertices.
+     * \param normals
+     *     The vector of vertex normals, equal in length to `vertices`.
+     * \param uvs
+     *     The vector of UV/texture coordinates, equal in length to `vertices`.
+     * \param indices
+     *     The triangle list of the full mesh.
+     * \param levels
+     *     The number of levels including the full mesh.
+     * \param ratio
+     *     The reduction of the triangles between levels.
+     *
+     * \throws std::runtime_error
+     *     If the indices are not a triangle list of the vertices.
+     */
+    static Mesh* lod_mesh(
+        const std::vector<Vec3>& vertices,
+        const std::vector<Vec3>& normals,
+        const std::vector<Vec2>& uvs,
+        const std::vector<unsigned int>& indices,
+        unsigned int levels = 4,
+        float ratio = 0.25f
+    );
+
     /**
      * Creates a mesh from the given buffer arrays.
      *
@@ -84,17 +171,107 @@ public:
         unsigned int mode = GL_TRIANGLES
     );
 
+    /**
+     * Creates a mesh from raw interleaved vertex data.
+     *
+     * \param format
+     *     The layout of the vertices, with a single stream.
+     * \param vertices
+     *     The vertex data, `vertexCount * format.get_stride(0)` bytes long.
+     * \param vertexCount
+     *     The number of vertices.
+     * \param indices
+     *     The index array used for rendering primitives.
+     * \param mode
+     *     The OpenGL primitive mode used to render the vertices.
+     *
+     * \throws std::runtime_error
+     *     If the format does not have a single stream.
+     */
+    Mesh(
+        const VertexFormat& format,
+        const void* vertices,
+        unsigned int vertexCount,
+        const std::vector<unsigned int>& indices,
+        unsigned int mode = GL_TRIANGLES
+    );
+
+    /**
+     * Creates a mesh from raw vertex data split into streams, each stored in
+     * its own vertex buffer. Attributes that are updated or used separately,
+     * e.g. positions for a depth pass, are best kept in their own stream.
+     *
+     * \param format
+     *     The layout of the vertices.
+     * \param streams
+     *     The data of each stream, `vertexCount * format.get_stride(i)` bytes
+     *     long for stream i.
+     * \param vertexCount
+     *     The number of vertices.
+     * \param indices
+     *     The index array used for rendering primitives.
+     * \param mode
+     *     The OpenGL primitive mode used to render the vertices.
+     *
+     * \throws std::runtime_error
+     *     If the number of streams does not match the format.
+     */
+    Mesh(
+        const VertexFormat& format,
+        const std::vector<const void*>& streams,
+        unsigned int vertexCount,
+        const std::vector<unsigned int>& indices,
+        unsigned int mode = GL_TRIANGLES
+    );
+
+    /**
+     * Creates a mesh from raw interleaved vertex data and 16-bit indices,
+     * which avoids widening and narrowing indices back.
+     */
+    Mesh(
+        const VertexFormat& format,
+        const void* vertices,
+        unsigned int vertexCount,
+        const std::vector<std::uint16_t>& indices,
+        unsigned int mode = GL_TRIANGLES
+    );
+
+    /**
+     * Creates a mesh from raw vertex data split into streams and 16-bit
+     * indices.
+     */
+    Mesh(
+        const VertexFormat& format,
+        const std::vector<const void*>& streams,
+        unsigned int vertexCount,
+        const std::vector<std::uint16_t>& indices,
+        unsigned int mode = GL_TRIANGLES
+    );
+
+    /**
+     * Creates an empty mesh to fill with set_vertices() and set_indices(),
+     * e.g. for geometry generated every frame. Its buffers grow as needed.
+     *
+     * \param format
+     *     The layout of the vertices.
+     * \param usage
+     *     How often the buffers are updated.
+     * \param mode
+     *     The OpenGL primitive mode used to render the vertices.
+     */
+    Mesh(const VertexFormat& format, Usage usage, unsigned int mode = GL_TRIANGLES);
+
     /**
      * Clears resources used by the mesh.
      */
     ~Mesh();
 
     /**
-     * Returns a handle to the OpenGL vertex buffer object.
+     * Returns a handle to the OpenGL vertex buffer object of a stream.
      */
-    unsigned int get_vbo_handle() const
+    unsigned int get_vbo_handle(unsigned int stream = 0) const
     {
-        return _vbo;
+        return _vbos[stream];
     }
 
     /**
@@ -113,6 +290,114 @@ public:
         return _vao;
     }
 
+    /**
+     * Returns the number of indices of the mesh, in all its levels of detail.
+     */
+    unsigned int get_index_count() const
+    {
+        return _numIndices;
+    }
+
+    /**
+     * Returns the type of the indices, GL_UNSIGNED_SHORT when all indices fit
+     * in 16 bits and GL_UNSIGNED_INT otherwise.
+     */
+    unsigned int get_index_type() const
+    {
+        return _indexType;
+    }
+
+    /**
+     * Returns the number of vertices in the mesh.
+     */
+    unsigned int get_vertex_count() const
+    {
+        return _numVertices;
+    }
+
+    /**
+     * Returns how often the buffers are updated.
+     */
+    Usage get_usage() const
+    {
+        return _usage;
+    }
+
+    /**
+     * Replaces the vertices of a stream, orphaning its buffer so that the
+     * driver need not wait for draws still reading it. The buffer grows by
+     * at least half its capacity when too small, and never shrinks.
+     *
+     * The other streams should be set to the same vertex count, and the
+     * bounds are recomputed when the stream holds float positions.
+     *
+     * \param data
+     *     The vertex data, `count * get_vertex_format().get_stride(stream)`
+     *     bytes long.
+     * \param count
+     *     The number of vertices.
+     * \param stream
+     *     The stream to replace.
+     *
+     * \throws std::runtime_error
+     *     If the stream is out of range.
+     */
+    void set_vertices(const void* data, unsigned int count, unsigned int stream = 0);
+
+    /**
+     * Overwrites a range of the vertices of a stream, keeping the others.
+     * Vertices past the end are appended, growing the buffer as needed. The
+     * bounds only grow, as the overwritten vertices are not read back.
+     *
+     * \param data
+     *     The vertex data, `count * get_vertex_format().get_stride(stream)`
+     *     bytes long.
+     * \param first
+     *     The first vertex to overwrite.
+     * \param count
+     *     The number of vertices to overwrite.
+     * \param stream
+     *     The stream to update.
+     *
+     * \throws std::runtime_error
+     *     If the stream is out of range.
+     */
+    void update_vertices(const void* data, unsigned int first, unsigned int count, unsigned int stream = 0);
+
+    /**
+     * Replaces the indices, with 16-bit indices when they fit, orphaning the
+     * buffer and growing it like set_vertices(). Clears the levels of detail.
+     */
+    void set_indices(const std::vector<unsigned int>& indices);
+
+    void set_indices(const std::vector<std::uint16_t>& indices);
+
+    /**
+     * Overwrites a range of the indices, keeping their type. Indices past the
+     * end are appended, growing the buffer as needed.
+     *
+     * \throws std::runtime_error
+     *     If the indices are 16-bit and an index does not fit.
+     */
+    void update_indices(const std::vector<unsigned int>& indices, unsigned int first);
+
+    /**
+     * Sets the number of indices to render without uploading any, e.g. to
+     * draw part of a buffer filled ahead. Clears the levels of detail.
+     *
+     * \throws std::runtime_error
+     *     If the count exceeds the capacity of the index buffer.
+     */
+    void set_index_count(unsigned int count);
+
+    /**
+     * Returns the layout of the vertices.
+     */
+    const VertexFormat& get_vertex_format() const
+    {
+        return _format;
+    }
+
     /**
      * Returns the render mode of the mesh.
      */
@@ -121,17 +406,153 @@ public:
         return _renderMode;
     }
 
+    /**
+     * Returns the axis-aligned bounding box of the vertices in model space,
+     * computed from the float attribute at location 0, or the positions of a
+     * compressed mesh. It is empty if the mesh has no vertices or no such
+     * attribute. Use transform() with the model
+     * matrix for the bounds in world space.
+     */
+    const Aabb& get_bounds() const
+    {
+        return _bounds;
+    }
+
+    /**
+     * Returns a bounding sphere of the vertices in model space, centered on
+     * the bounding box. Use transform() with the model matrix for the sphere
+     * in world space.
+     */
+    const Sphere& get_bounding_sphere() const
+    {
+        return _boundingSphere;
+    }
+
+    /**
+     * Sets the levels of detail of the mesh as ranges of its indices, from
+     * the full mesh to the coarsest, e.g. from MeshOptimizer::generate_lods().
+     * A mesh without levels renders all of its indices.
+     *
+     * \throws std::runtime_error
+     *     If a range is outside of the indices.
+     */
+    void set_lods(const std::vector<MeshLod>& lods);
+
+    /**
+     * Returns the number of levels of detail, at least 1.
+     */
+    unsigned int get_lod_count() const
+    {
+        return _lods.empty() ? 1 : _lods.size();
+    }
+
+    /**
+     * Returns a level of detail, 0 being the full mesh.
+     */
+    MeshLod get_lod(unsigned int lod) const
+    {
+        return _lods.empty() ? MeshLod{0, _numIndices, 0.0f} : _lods[lod];
+    }
+
+    /**
+     * Returns the coarsest level of detail whose error stays under a number
+     * of pixels on screen, estimated at the nearest point of the bounding
+     * sphere.
+     *
+     * \param modelView
+     *     The view * model matrix of the mesh.
+     * \param projection
+     *     The projection matrix.
+     * \param viewportHeight
+     *     The height of the viewport in pixels.
+     * \param pixelError
+     *     The largest error allowed in pixels.
+     */
+    unsigned int select_lod(
+        const Mat4& modelView,
+        const Mat4& projection,
+        float viewportHeight,
+        float pixelError = 1.0f
+    ) const;
+
+    /**
+     * Returns the matrix which decodes quantized positions into model space,
+     * to apply after the model matrix. It is the identity for float
+     * positions.
+     */
+    const Mat4& get_position_transform() const
+    {
+        return _positionTransform;
+    }
+
 private:
 
     friend class Context;
+    friend class ShapeBatch;
+
+    /**
+     * Uploads the buffers, with 16-bit indices when they fit, and creates the
+     * vertex array object.
+     */
+    void _create(const std::vector<const void*>& streams, const std::vector<unsigned int>& indices);
+
+    void _create(const std::vector<const void*>& streams, const void* indices, unsigned int indexType);
+
+    /**
+     * Computes the bounding volumes from the positions in the streams.
+     */
+    void _compute_bounds(const std::vector<const void*>& streams);
+
+    void _compute_bounds(const std::vector<Vec3>& positions);
+
+    /**
+     * Reads the positions of count vertices of a stream.
+     *
+     * \returns
+     *     False if the stream does not hold float positions.
+     */
+    bool _read_positions(const void* data, unsigned int stream, unsigned int count,
+                         std::vector<Vec3>& positions) const;
+
+    void _set_indices(const void* indices, unsigned int count, unsigned int indexType);
+
+    /**
+     * Binds the buffers and sets the attributes of the mesh in the bound
+     * vertex array object.
+     */
+    void _bind_attributes() const;
+
+    /**
+     * Returns the vertex array object used for instanced draws, which shares
+     * the buffers of the mesh, creating and binding it on first use.
+     */
+    unsigned int _get_instance_vao() const;
+
+    /**
+     * Points the instance attributes of the bound instance vertex array at
+     * instances of the given format in a buffer.
+     */
+    void _bind_instances(const VertexFormat& format, unsigned int buffer, unsigned int offset) const;
 
-    void _render() const;
+    void _render(unsigned int lod, unsigned int instances = 1) const;
 
+    VertexFormat _format;
+    unsigned int _numVertices;
     unsigned int _numIndices;
-    unsigned int _vbo;
+    std::vector<unsigned int> _vbos;
+    std::vector<unsigned int> _vboCapacities;
     unsigned int _ebo;
+    unsigned int _eboCapacity;
     unsigned int _vao;
+    unsigned int _indexType;
+    Usage _usage;
     unsigned int _renderMode;
+    Aabb _bounds;
+    Sphere _boundingSphere;
+    Mat4 _positionTransform;
+    std::vector<MeshLod> _lods;
+    mutable unsigned int _instanceVao;
+    mutable std::vector<unsigned int> _instanceLocations;
 
 };
 
@@ -0,0 +1,240 @@
+#ifndef _JELLY_MESH_OPTIMIZER_HPP_
+#define _JELLY_MESH_OPTIMIZER_HPP_
+
+#include <vector>
+
+#include <jelly/math/vec2.hpp>
+#include <jelly/math/vec3.hpp>
+
+namespace jelly {
+
+/**
+ * The efficiency of the GPU post-transform vertex cache for a triangle list,
+ * simulated as a FIFO cache.
+ */
+struct VertexCacheStats {
+
+    /**
+     * The average number of vertices transformed per triangle, from 0.5 for
+     * large regular grids to 3 without any reuse.
+     */
+    float acmr;
+
+    /**
+     * The average number of times each vertex is transformed, 1 at best.
+     */
+    float atvr;
+
+};
+
+
+/**
+ * A level of detail of a mesh, as a range of its indices.
+ */
+struct MeshLod {
+
+    /**
+     * The first index of the level.
+     */
+    unsigned int first;
+
+    /**
+     * The number of indices of the level.
+     */
+    unsigned int count;
+
+    /**
+     * The approximate distance between the level and the full mesh, in model
+     * units.
+     */
+    float error;
+
+};
+
+
+/**
+ * Reorders triangle lists and their vertices to render faster:
+ *
+ * 1. optimize_vertex_cache() orders the triangles to reuse the vertices in
+ *    the post-transform cache of the GPU.
+ * 2. optimize_overdraw() then orders clusters of those triangles to draw the
+ *    outward-facing ones first, which likely occlude the others, while mostly
+ *    keeping the cache reuse.
+ * 3. optimize_vertex_fetch() finally orders the vertices by first use, for
+ *    the locality of the vertex fetches.
+ *
+ * optimize() runs the whole pipeline on the standard mesh attributes. The
+ * triangles are reordered, never changed, so the mesh renders the same.
+ *
+ * simplify() and generate_lods() on the other hand reduce the triangles, for
+ * levels of detail that share the vertices of the full mesh.
+ */
+class MeshOptimizer {
+
+public:
+
+    /**
+     * The cache statistics before and after optimization.
+     */
+    struct Report {
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+
+    /**
+     * The size of the FIFO cache used to simulate the GPU, which matches
+     * most hardware.
+     */
+    static const unsigned int CACHE_SIZE = 16;
+
+    /**
+     * Simulates the vertex cache for a triangle list.
+     *
+     * \param indices
+     *     The triangle list.
+     * \param vertexCount
+     *     The number of vertices.
+     * \param cacheSize
+     *     The number of vertices in the FIFO cache.
+     */
+    static VertexCacheStats analyze_vertex_cache(
+        const std::vector<unsigned int>& indices,
+        unsigned int vertexCount,
+        unsigned int cacheSize = CACHE_SIZE
+    );
+
+    /**
+     * Orders the triangles for vertex cache reuse, see T. Forsyth, "Linear-
+     * Speed Vertex Cache Optimisation".
+     *
+     * \throws std::runtime_error
+     *     If the indices are not a triangle list of vertexCount vertices.
+     */
+    static void optimize_vertex_cache(std::vector<unsigned int>& indices, unsigned int vertexCount);
+
+    /**
+     * Orders clusters of triangles of a cache optimized list to reduce
+     * overdraw, see P. Sander et al., "Fast Triangle Reordering for Vertex
+     * Locality and Reduced Overdraw".
+     *
+     * \param indices
+     *     The triangle list, already ordered by optimize_vertex_cache().
+     * \param positions
+     *     The vertex positions.
+     * \param threshold
+     *     How much worse the ACMR may get for smaller clusters, which sort
+     *     better, e.g. 1.05 for up to 5% worse.
+     *
+     * \throws std::runtime_error
+     *     If the indices are not a triangle list of the positions.
+     */
+    static void optimize_overdraw(
+        std::vector<unsigned int>& indices,
+        const std::vector<Vec3>& positions,
+        float threshold = 1.05f
+    );
+
+    /**
+     * Orders the vertices by first use in the triangle list, updating the
+     * indices. Unused vertices are moved to the end.
+     *
+     * \returns
+     *     The new index of each vertex, to reorder the attributes with
+     *     remap_vertices().
+     */
+    static std::vector<unsigned int> optimize_vertex_fetch(
+        std::vector<unsigned int>& indices,
+        unsigned int vertexCount
+    );
+
+    /**
+     * Moves the attribute of each vertex to its new index.
+     */
+    template <typename T>
+    static void remap_vertices(std::vector<T>& attribute, const std::vector<unsigned int>& remap)
+    {
+        std::vector<T> result(attribute.size());
+        for (unsigned int i = 0; i < attribute.size(); ++i) {
+            result[remap[i]] = attribute[i];
+        }
+        attribute.swap(result);
+    }
+
+    /**
+     * Simplifies a triangle list by collapsing edges onto their vertices in
+     * order of quadric error, see M. Garland and P. Heckbert, "Surface
+     * Simplification Using Quadric Error Metrics". The vertices of borders,
+     * including UV and normal seams, are kept to avoid cracks.
+     *
+     * \param indices
+     *     The triangle list.
+     * \param positions
+     *     The vertex positions.
+     * \param targetIndexCount
+     *     The number of indices to reduce to, which may not be reached.
+     * \param error
+     *     If not null, set to the approximate distance between the simplified
+     *     and the original triangles.
+     *
+     * \returns
+     *     The simplified triangle list, of the same vertices.
+     *
+     * \throws std::runtime_error
+     *     If the indices are not a triangle list of the positions.
+     */
+    static std::vector<unsigned int> simplify(
+        const std::vector<unsigned int>& indices,
+        const std::vector<Vec3>& positions,
+        unsigned int targetIndexCount,
+        float* error = nullptr
+    );
+
+    /**
+     * Appends simplified levels of detail of a triangle list to it, each
+     * with about ratio times the triangles of the previous one and ordered
+     * for the vertex cache. Fewer levels are generated when the triangles
+     * cannot be reduced further.
+     *
+     * \param indices
+     *     The triangle list of the full mesh, to which the levels are
+     *     appended.
+     * \param positions
+     *     The vertex positions.
+     * \param levels
+     *     The number of levels including the full mesh.
+     * \param ratio
+     *     The reduction of the triangles between levels.
+     *
+     * \returns
+     *     The ranges of the levels in the indices, starting with the full
+     *     mesh.
+     */
+    static std::vector<MeshLod> generate_lods(
+        std::vector<unsigned int>& indices,
+        const std::vector<Vec3>& positions,
+        unsigned int levels,
+        float ratio = 0.5f
+    );
+
+    /**
+     * Runs the whole pipeline on the standard mesh attributes.
+     *
+     * \param report
+     *     If not null, set to the cache statistics before and after.
+     *
+     * \throws std::runtime_error
+     *     If the indices are not a triangle list of the vertices.
+     */
+    static void optimize(
+        std::vector<Vec3>& vertices,
+        std::vector<Vec3>& normals,
+        std::vector<Vec2>& uvs,
+        std::vector<unsigned int>& indices,
+        Report* report = nullptr
+    );
+
+};
+
+}
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef _JELLY_RENDER_QUEUE_HPP_
+#define _JELLY_RENDER_QUEUE_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <jelly/gl/mesh.hpp>
+#include <jelly/gl/shader.hpp>
+#include <jelly/gl/uniform.hpp>
+
+namespace jelly {
+
+class Context;
+
+/**
+ * A queue of recorded draws that are sorted to minimize state changes before
+ * being submitted to a context.
+ *
+ * Every draw is recorded as a packet holding its shader, mesh and uniform
+ * values, and a 64-bit sort key built from its layer, pass, shader, first
+ * texture, mesh and depth:
+ *
+ *     queue.draw(shader, mesh, 1)
+ *         .set_uniform(u_Model, model)
+ *         .set_uniform(u_Albedo, albedo);
+ *     ...
+ *     queue.submit(context);
+ *
+ * Layers are always drawn in increasing order. Within a layer, opaque draws
+ * come first, grouped by shader, texture and mesh and then front to back.
+ * Translucent draws follow, back to front, and in recording order when their
+ * depths are equal so that 2D painter's ordering is preserved.
+ */
+class RenderQueue {
+
+public:
+
+    /**
+     * The render pass of a draw.
+     */
+    enum class Pass {
+        OPAQUE,
+        TRANSLUCENT
+    };
+
+    /**
+     * A recorded draw, used to attach uniform values to it. Only valid until
+     * the next draw is recorded.
+     */
+    class Draw {
+
+    public:
+
+        template <typename T>
+        Draw& set_uniform(const Uniform<T>& u, const T& value)
+        {
+            _queue->_add_uniform(u.get_location(), value);
+            return *this;
+        }
+
+        /**
+         * Draws a level of detail of the mesh instead of the full mesh, see
+         * Mesh::select_lod().
+         */
+        Draw& set_lod(unsigned int lod)
+        {
+            _queue->_packets.back().lod = lod;
+            return *this;
+        }
+
+    private:
+
+        friend class RenderQueue;
+
+        explicit Draw(RenderQueue* queue) : _queue(queue) {}
+
+        RenderQueue* _queue;
+
+    };
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    RenderQueue();
+
+    /**
+     * Records a draw of the mesh with the shader.
+     *
+     * \param layer
+     *     The layer of the draw, from 0 to 255. Higher layers are drawn on
+     *     top of lower ones.
+     * \param depth
+     *     The distance of the draw from the viewer, used to order draws within
+     *     a layer.
+     * \param pass
+     *     Whether the draw is opaque or blended with the draws behind it.
+     */
+    Draw draw(
+        Shader& shader,
+        const Mesh& mesh,
+        unsigned int layer = 0,
+        float depth = 0.0f,
+        Pass pass = Pass::OPAQUE
+    );
+
+    /**
+     * Sorts the recorded draws and renders them, then clears the queue.
+     */
+    void submit(Context& c);
+
+    /**
+     * Clears the recorded draws without rendering them.
+     */
+    void clear();
+
+    /**
+     * Returns the number of recorded draws.
+     */
+    unsigned int size() const { return _packets.size(); }
+
+    /**
+     * Returns the number of shader changes made by the last submit.
+     */
+    unsigned int get_shader_switch_count() const { return _shaderSwitches; }
+
+private:
+
+    /**
+     * A recorded uniform value of a packet.
+     */
+    struct UniformValue {
+        int location;
+        unsigned int type;
+        const Texture* texture;
+        float data[16];
+    };
+
+    /**
+     * A recorded draw.
+     */
+    struct Packet {
+        Shader* shader;
+        const Mesh* mesh;
+        unsigned int firstUniform;
+        unsigned int numUniforms;
+        unsigned int layer;
+        unsigned int pass;
+        float depth;
+        unsigned int lod;
+    };
+
+    void _add_uniform(int location, int value);
+    void _add_uniform(int location, float value);
+    void _add_uniform(int location, const Vec2& value);
+    void _add_uniform(int location, const Vec3& value);
+    void _add_uniform(int location, const Vec4& value);
+    void _add_uniform(int location, const Mat3& value);
+    void _add_uniform(int location, const Mat4& value);
+    void _add_uniform(int location, const Texture& value);
+
+    UniformValue& _push_uniform(int location, unsigned int type);
+
+    /**
+     * Builds the sort key of a packet.
+     */
+    std::uint64_t _sort_key(const Packet& packet) const;
+
+    /**
+     * Sorts the packet order by key with a stable LSD radix sort, so equal
+     * keys keep their recording order.
+     */
+    void _sort();
+
+    std::vector<Packet> _packets;
+    std::vector<UniformValue> _uniforms;
+    std::vector<std::uint64_t> _keys, _keysTemp;
+    std::vector<unsigned int> _order, _orderTemp;
+    unsigned int _shaderSwitches;
+
+};
+
+}
+
+#endif
@@ -1,12 +1,16 @@
 #ifndef _JELLY_SHADER_HPP_
 #define _JELLY_SHADER_HPP_
 
+#include <cstdint>
 #include <string>
 #include <map>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <jelly/math.hpp>
 #include <jelly/gl/texture.hpp>
+#include <jelly/gl/uniform.hpp>
 
 namespace jelly {
 
@@ -26,17 +30,42 @@ public:
     Shader& operator=(const Shader&) = delete;
     Shader() = delete;
 
+    /**
+     * Shader compilation modes.
+     */
+    enum class Compilation {
+        /**
+         * Compile and link in the constructor, throwing on errors.
+         */
+        IMMEDIATE,
+
+        /**
+         * Submit the code to the driver and only wait for the result when the
+         * shader is first used. Creating many deferred shaders before using
+         * any of them lets drivers supporting KHR_parallel_shader_compile
+         * compile them on multiple threads.
+         */
+        DEFERRED
+    };
+
     /**
      * Creates a shader from the given GLSL vertex and fragment shader code.
      *
+     * If a ShaderCache directory is set, a program binary cached for the same
+     * code is loaded instead of compiling it.
+     *
      * \param vs
      *     The complete vertex shader code.
      * \param fs
      *     The complete fragment shader code.
+     * \param mode
+     *     Whether to wait for the compilation to finish.
      *
-     * \throw std::runtime_error if the shader compilation failed.
+     * \throw std::runtime_error if the shader compilation failed. Deferred
+     * shaders throw when they are first used instead, i.e. when activated,
+     * waited for, or when their uniforms are accessed.
      */
-    Shader(const std::string& vs, const std::string& fs);
+    Shader(const std::string& vs, const std::string& fs, Compilation mode = Compilation::IMMEDIATE);
 
     /**
      * Clears all resources used by the shader.
@@ -44,45 +73,148 @@ public:
     ~Shader();
 
     /**
-     * Returns the handle to the uniform.
+     * Returns true if the shader can be used without waiting for the driver
+     * to finish compiling. Always false for deferred shaders that have not
+     * been used yet if the driver does not support
+     * KHR_parallel_shader_compile.
+     */
+    bool is_ready() const;
+
+    /**
+     * Blocks until a deferred shader is compiled and linked.
+     *
+     * \throw std::runtime_error if the shader compilation failed.
+     */
+    void wait();
+
+    /**
+     * Returns true if the program has an active uniform with the given name.
+     */
+    bool has_uniform(const std::string& u);
+
+    bool has_uniform(UniformName u);
+
+    /**
+     * Returns the handle to the uniform, or -1 if the program has no active
+     * uniform with the given name. A warning is printed the first time an
+     * unknown name is requested.
      *
      * \param u
      *     The name of the shader uniform.
      */
     unsigned int get_uniform_handle(const std::string& u);
 
+    unsigned int get_uniform_handle(UniformName u);
+
+    /**
+     * Returns a typed handle to the uniform. The handle is invalid, and a
+     * warning is printed, if the program has no active uniform with the given
+     * name or if its type does not match T.
+     *
+     * \param u
+     *     The name of the shader uniform.
+     */
+    template <typename T>
+    Uniform<T> get_uniform(const std::string& u)
+    {
+        return Uniform<T>(_typed_location(
+            get_uniform_handle(u),
+            UniformTraits<T>::COMPONENTS,
+            UniformTraits<T>::INTEGER,
+            UniformTraits<T>::SAMPLER
+        ));
+    }
+
+    template <typename T>
+    Uniform<T> get_uniform(UniformName u)
+    {
+        return Uniform<T>(_typed_location(
+            get_uniform_handle(u),
+            UniformTraits<T>::COMPONENTS,
+            UniformTraits<T>::INTEGER,
+            UniformTraits<T>::SAMPLER
+        ));
+    }
+
+    void set_uniform(const Uniform<int>& u, int i) { set_uniform_int(u.get_location(), i); }
+
+    void set_uniform(const Uniform<float>& u, float f) { set_uniform_float(u.get_location(), f); }
+
+    void set_uniform(const Uniform<Vec2>& u, const Vec2& v) { set_uniform_vec2(u.get_location(), v); }
+
+    void set_uniform(const Uniform<Vec3>& u, const Vec3& v) { set_uniform_vec3(u.get_location(), v); }
+
+    void set_uniform(const Uniform<Vec4>& u, const Vec4& v) { set_uniform_vec4(u.get_location(), v); }
+
+    void set_uniform(const Uniform<Mat3>& u, const Mat3& m) { set_uniform_mat3(u.get_location(), m); }
+
+    void set_uniform(const Uniform<Mat4>& u, const Mat4& m) { set_uniform_mat4(u.get_location(), m); }
+
+    void set_uniform(const Uniform<Texture>& u, const Texture& t) { set_uniform_sampler(u.get_location(), t); }
+
     void set_uniform_int(const std::string& u, int);
 
+    void set_uniform_int(UniformName u, int);
+
     void set_uniform_int(unsigned int u, int);
 
     void set_uniform_float(const std::string& u, float);
 
+    void set_uniform_float(UniformName u, float);
+
     void set_uniform_float(unsigned int u, float);
 
     void set_uniform_vec2(const std::string& u, const Vec2&);
 
+    void set_uniform_vec2(UniformName u, const Vec2&);
+
     void set_uniform_vec2(unsigned int u, const Vec2&);
 
     void set_uniform_vec3(const std::string& u, const Vec3&);
 
+    void set_uniform_vec3(UniformName u, const Vec3&);
+
     void set_uniform_vec3(unsigned int u, const Vec3&);
 
     void set_uniform_vec4(const std::string& u, const Vec4&);
 
+    void set_uniform_vec4(UniformName u, const Vec4&);
+
     void set_uniform_vec4(unsigned int u, const Vec4&);
 
     void set_uniform_mat3(const std::string& u, const Mat3&);
 
+    void set_uniform_mat3(UniformName u, const Mat3&);
+
     void set_uniform_mat3(unsigned int u, const Mat3&);
 
     void set_uniform_mat4(const std::string& u, const Mat4&);
 
+    void set_uniform_mat4(UniformName u, const Mat4&);
+
     void set_uniform_mat4(unsigned int u, const Mat4&);
 
     void set_uniform_sampler(const std::string& u, const Texture&);
 
+    void set_uniform_sampler(UniformName u, const Texture&);
+
     void set_uniform_sampler(unsigned int u, const Texture&);
 
+    /**
+     * Connects a uniform block of the program to a uniform buffer binding
+     * point.
+     *
+     * \param block
+     *     The name of the uniform block.
+     * \param binding
+     *     The binding point, as used with Context::bind_uniform_buffer().
+     *
+     * \return
+     *     False, after printing a warning, if the program has no active uniform
+     *     block with the given name.
+     */
+    bool set_uniform_block(const std::string& block, unsigned int binding);
+
     bool is_active() const {
         return _activeContext != nullptr;
     }
@@ -98,22 +230,78 @@ private:
 
     friend class Context;
 
+    /**
+     * A reflected active uniform whose value is stored in the uniform block.
+     */
+    struct UniformSlot {
+        int location;
+        unsigned int type;
+        unsigned int offset;
+        unsigned int components;
+        bool integer;
+        int sampler;
+        bool dirty;
+    };
+
+    /**
+     * The hash of an active uniform name, with the name to tell colliding
+     * names apart.
+     */
+    struct UniformHash {
+        std::uint32_t hash;
+        int location;
+        std::string name;
+    };
+
     void _activate(Context*);
     void _deactivate();
 
-    unsigned int _programHandle, _vertexShaderHandle, _fragmentShaderHandle;
-    std::map<std::string, unsigned int> _uniformNameMap;
+    /**
+     * Waits for a deferred shader to finish compiling, then reflects its
+     * uniforms. Does nothing if the shader is already finalized.
+     */
+    void _finalize();
+
+    /**
+     * Enumerates the active uniforms of the linked program and lays out their
+     * values in the uniform block.
+     */
+    void _reflect_uniforms();
+
+    /**
+     * Returns the location of the active uniform with the given name, or -1
+     * if there is none.
+     */
+    int _find_uniform(UniformName u) const;
 
-    std::map<unsigned int, int> _intUniformCache;
-    std::map<unsigned int, float> _floatUniformCache;
-    std::map<unsigned int, Vec2> _vec2UniformCache;
-    std::map<unsigned int, Vec3> _vec3UniformCache;
-    std::map<unsigned int, Vec4> _vec4UniformCache;
-    std::map<unsigned int, Mat3> _mat3UniformCache;
-    std::map<unsigned int, Mat4> _mat4UniformCache;
-    std::map<unsigned int, const Texture*> _samplerUniformCache;
+    /**
+     * Stores a uniform value, uploading it immediately if the shader is active
+     * or marking it dirty otherwise. Unchanged values are ignored, and
+     * samplers are rejected like other mismatching types.
+     */
+    void _store_uniform(unsigned int u, const void* value, unsigned int components, bool integer);
 
-    std::map<unsigned int, unsigned int> _samplerBindingLocations;
+    void _upload_uniform(const UniformSlot&) const;
+
+    /**
+     * Returns the location if the uniform at that location has the given type,
+     * or -1 after printing a warning otherwise.
+     */
+    int _typed_location(unsigned int u, unsigned int components, bool integer, bool sampler) const;
+
+    unsigned int _programHandle, _vertexShaderHandle, _fragmentShaderHandle;
+    bool _pending;
+    double _compileSeconds;
+    std::string _vertexSource, _fragmentSource;
+    std::map<std::string, unsigned int> _uniformNameMap;
+    std::vector<UniformHash> _uniformHashes;
+    std::vector<std::uint32_t> _unknownUniformHashes;
+
+    std::vector<UniformSlot> _uniforms;
+    std::vector<int> _uniformSlotsByLocation;
+    std::vector<float> _uniformData;
+    std::vector<unsigned int> _dirtyUniforms;
+    std::vector<const Texture*> _samplerTextures;
 
     Context* _activeContext;
 
@@ -0,0 +1,111 @@
+#ifndef _JELLY_SHADER_CACHE_HPP_
+#define _JELLY_SHADER_CACHE_HPP_
+
+#include <string>
+
+namespace jelly {
+
+/**
+ * A persistent on-disk cache of linked shader program binaries.
+ *
+ * When a cache directory is set, every Shader first tries to load a program
+ * binary stored by a previous run for the same sources and driver, skipping
+ * GLSL compilation entirely. Binaries rejected by the driver, e.g. after a
+ * driver update, are transparently replaced by compiling the sources again.
+ *
+ * \note Requires OpenGL 4.1 or ARB_get_program_binary, the cache is bypassed
+ * otherwise.
+ */
+class ShaderCache {
+
+public:
+
+    /**
+     * Cache usage statistics.
+     */
+    struct Stats {
+
+        /**
+         * The number of programs loaded from the cache.
+         */
+        unsigned int hits;
+
+        /**
+         * The number of programs compiled because no binary was cached.
+         */
+        unsigned int misses;
+
+        /**
+         * The number of cached binaries rejected as corrupt or by the driver.
+         */
+        unsigned int rejected;
+
+        /**
+         * The time in seconds spent compiling and linking programs.
+         */
+        double compile_seconds;
+
+        /**
+         * The time in seconds spent loading cached binaries.
+         */
+        double load_seconds;
+
+        /**
+         * The estimated time in seconds saved by loading cached binaries,
+         * based on the average compilation time of the misses.
+         */
+        double saved_seconds;
+
+    };
+
+    ShaderCache() = delete;
+
+    /**
+     * Sets the directory used to store program binaries, creating it if it
+     * does not exist yet. An empty path disables the cache, which is the
+     * default.
+     */
+    static void set_directory(const std::string& path);
+
+    /**
+     * Returns the cache directory, or an empty string if caching is disabled.
+     */
+    static const std::string& get_directory();
+
+    /**
+     * Returns true if a cache directory is set and the driver supports
+     * program binaries.
+     */
+    static bool is_enabled();
+
+    /**
+     * Returns the cache statistics since the start of the program or the last
+     * call to reset_stats().
+     */
+    static Stats get_stats();
+
+    /**
+     * Resets the cache statistics to zero.
+     */
+    static void reset_stats();
+
+private:
+
+    friend class Shader;
+
+    /**
+     * Returns a linked program loaded from the cache, or 0 on a miss.
+     */
+    static unsigned int _load(const std::string& vs, const std::string& fs);
+
+    /**
+     * Stores the binary of a freshly linked program and records the time it
+     * took to compile.
+     */
+    static void _store(unsigned int program, const std::string& vs, const std::string& fs, double seconds);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef _JELLY_SHADER_TEMPLATE_HPP_
+#define _JELLY_SHADER_TEMPLATE_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <jelly/gl/shader.hpp>
+
+namespace jelly {
+
+/**
+ * A shader with preprocessor features that generates a Shader per combination
+ * of feature values, i.e. per permutation, when it is first requested.
+ *
+ * Every feature is injected as a `#define` after the `#version` line, so the
+ * shader code can select code paths with `#if`:
+ *
+ *     ShaderTemplate tmpl(vs, fs);
+ *     ShaderTemplate::Feature stroke = tmpl.add_feature("STROKE");
+ *     ShaderTemplate::Feature lights = tmpl.add_feature("NUM_LIGHTS", 4);
+ *     Shader& shader = tmpl.get(stroke(1) | lights(3));
+ *
+ * Features that are not referenced by either stage are left out of the key,
+ * so permutations that would generate identical code share a single Shader.
+ */
+class ShaderTemplate {
+
+public:
+
+    /**
+     * A feature key, combining the values of all features in a bit mask.
+     */
+    typedef std::uint64_t Key;
+
+    /**
+     * A handle to a feature, used to build keys.
+     */
+    class Feature {
+
+    public:
+
+        /**
+         * Returns the key bits that set this feature to the given value.
+         * Values above the feature's maximum are clamped.
+         */
+        Key operator()(unsigned int value) const
+        {
+            Key max = (Key(1) << _bits) - 1;
+            Key v = value < _max ? value : _max;
+            return (v & max) << _offset;
+        }
+
+    private:
+
+        friend class ShaderTemplate;
+
+        Feature(unsigned int offset, unsigned int bits, unsigned int max) :
+            _offset(offset),
+            _bits(bits),
+            _max(max)
+        {}
+
+        unsigned int _offset;
+        unsigned int _bits;
+        unsigned int _max;
+
+    };
+
+    ShaderTemplate() = delete;
+    ShaderTemplate(const ShaderTemplate&) = delete;
+    ShaderTemplate& operator=(const ShaderTemplate&) = delete;
+
+    /**
+     * Creates a template from the given GLSL vertex and fragment shader code.
+     *
+     * \param vs
+     *     The complete vertex shader code.
+     * \param fs
+     *     The complete fragment shader code.
+     * \param mode
+     *     The compilation mode of the generated shaders.
+     */
+    ShaderTemplate(
+        const std::string& vs,
+        const std::string& fs,
+        Shader::Compilation mode = Shader::Compilation::IMMEDIATE
+    );
+
+    /**
+     * Clears all generated shaders.
+     */
+    ~ShaderTemplate();
+
+    /**
+     * Adds a boolean feature, defined as 0 or 1.
+     *
+     * \throw std::runtime_error if the features no longer fit in a Key.
+     */
+    Feature add_feature(const std::string& name);
+
+    /**
+     * Adds an integer feature, defined as a value from 0 to max inclusive.
+     *
+     * \throw std::runtime_error if the features no longer fit in a Key.
+     */
+    Feature add_feature(const std::string& name, unsigned int max);
+
+    /**
+     * Returns the shader for the given feature key, generating and compiling
+     * it if needed.
+     *
+     * \throw std::runtime_error if the shader compilation failed.
+     */
+    Shader& get(Key key);
+
+    /**
+     * Generates the shader for the given key without waiting for it to
+     * compile, allowing many permutations to be submitted up front.
+     */
+    void prepare(Key key);
+
+    /**
+     * Returns the number of distinct shaders generated so far.
+     */
+    unsigned int get_shader_count() const { return _shaders.size(); }
+
+    /**
+     * Returns the vertex shader code generated for the given key.
+     */
+    std::string generate_vertex_code(Key key) const;
+
+    /**
+     * Returns the fragment shader code generated for the given key.
+     */
+    std::string generate_fragment_code(Key key) const;
+
+private:
+
+    struct FeatureInfo {
+        std::string name;
+        Feature feature;
+        bool inVertex;
+        bool inFragment;
+    };
+
+    Shader& _variant(Key key, Shader::Compilation mode);
+
+    std::string _generate(const std::string& code, Key key, bool vertex) const;
+
+    std::string _vertexCode, _fragmentCode;
+    Shader::Compilation _mode;
+
+    std::vector<FeatureInfo> _features;
+    unsigned int _usedBits;
+    Key _referencedMask;
+
+    std::map<Key, std::unique_ptr<Shader>> _shaders;
+
+};
+
+}
+
+#endif
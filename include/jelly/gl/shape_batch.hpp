@@ -0,0 +1,146 @@
+#ifndef _JELLY_SHAPE_BATCH_HPP_
+#define _JELLY_SHAPE_BATCH_HPP_
+
+#include <vector>
+
+#include <jelly/math/vec4.hpp>
+
+namespace jelly {
+
+class Context;
+class Mesh;
+class Shader;
+
+/**
+ * The per-shape data of a ShapeBatch. Every shape is rendered as a single
+ * instance of the batch's quad mesh.
+ */
+struct ShapeInstance {
+
+    /**
+     * Shape types understood by the shape shader.
+     */
+    enum Type {
+        RECTANGLE = 0,
+        ELLIPSE = 1
+    };
+
+    /**
+     * The bounds of the shape in pixels as (x1, y1, x2, y2).
+     */
+    Vec4 rect;
+
+    /**
+     * The RGBA color of the shape.
+     */
+    Vec4 color;
+
+    /**
+     * The stroke size in pixels, or 0 to fill the shape.
+     */
+    float stroke;
+
+    /**
+     * The corner radius in pixels of rounded rectangles.
+     */
+    float radius;
+
+    /**
+     * The shape type, one of the Type constants.
+     */
+    int type;
+
+};
+
+/**
+ * Collects 2D shapes into the transient buffer of the context and renders them
+ * with as few instanced draw calls as possible.
+ *
+ * Shapes are only rendered when the batch is flushed, which happens
+ * automatically when a shape with a different shader is appended. The owner is
+ * responsible for flushing at the end of a frame and before any other
+ * rendering that depends on the batched shapes.
+ *
+ * The instance attributes are bound to the following shader locations:
+ *     3 - vec4 rectangle
+ *     4 - vec4 color
+ *     5 - float stroke size
+ *     6 - float corner radius
+ *     7 - int shape type, one of the ShapeInstance::Type constants
+ */
+class ShapeBatch {
+
+public:
+
+    ShapeBatch() = delete;
+    ShapeBatch(const ShapeBatch&) = delete;
+    ShapeBatch& operator=(const ShapeBatch&) = delete;
+
+    /**
+     * Creates a batch that renders instances of the given mesh.
+     *
+     * \param quad
+     *     The mesh to instance, usually Mesh::quad_mesh(). Its buffers are
+     *     shared with the batch, so the mesh must outlive the batch.
+     */
+    ShapeBatch(const Mesh& quad);
+
+    /**
+     * Clears resources used by the batch. Pending shapes are discarded.
+     */
+    ~ShapeBatch();
+
+    /**
+     * Appends a shape to be rendered with the given shader. If the pending
+     * shapes use a different shader, they are flushed first.
+     */
+    void append(Context& c, Shader& shader, const ShapeInstance& shape);
+
+    /**
+     * Renders all pending shapes in a single instanced draw call.
+     */
+    void flush(Context& c);
+
+    /**
+     * Returns the shader used by the pending shapes, or nullptr if no shapes
+     * are pending.
+     */
+    const Shader* get_shader() const { return _instances.empty() ? nullptr : _shader; }
+
+    /**
+     * Returns the number of shapes waiting to be rendered.
+     */
+    unsigned int get_pending_count() const { return _instances.size(); }
+
+    /**
+     * Returns the number of draw calls issued since the counters were reset.
+     */
+    unsigned int get_flush_count() const { return _flushCount; }
+
+    /**
+     * Returns the number of shapes rendered since the counters were reset.
+     */
+    unsigned int get_shape_count() const { return _shapeCount; }
+
+    /**
+     * Resets the flush and shape counters to zero.
+     */
+    void reset_counters();
+
+private:
+
+    std::vector<ShapeInstance> _instances;
+    Shader* _shader;
+
+    unsigned int _vao;
+    unsigned int _numIndices;
+    unsigned int _indexType;
+
+    unsigned int _flushCount;
+    unsigned int _shapeCount;
+
+};
+
+}
+
+#endif
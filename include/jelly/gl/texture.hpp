@@ -157,7 +157,7 @@ private:
 
     friend class Context;
 
-    void _bind(unsigned int index) const;
+    unsigned int _gl_target() const;
 
     unsigned int _handle;
     Type         _type;
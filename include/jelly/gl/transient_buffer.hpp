@@ -0,0 +1,192 @@
+#ifndef _JELLY_TRANSIENT_BUFFER_HPP_
+#define _JELLY_TRANSIENT_BUFFER_HPP_
+
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace jelly {
+
+/**
+ * A range of a TransientBuffer, valid until the end of the frame.
+ */
+struct TransientRange {
+
+    /**
+     * Where to write the data of the range, until it is committed.
+     */
+    void* data;
+
+    /**
+     * The OpenGL buffer holding the range.
+     */
+    unsigned int buffer;
+
+    /**
+     * The byte offset of the range in the buffer, e.g. for
+     * glVertexAttribPointer() or glDrawElements().
+     */
+    unsigned int offset;
+
+    /**
+     * The size of the range in bytes.
+     */
+    unsigned int size;
+
+};
+
+
+/**
+ * A ring buffer for data written once per frame and read by the GPU in that
+ * frame only, e.g. batched instances, generated vertices and indices or
+ * uniform blocks changing for every draw.
+ *
+ * The buffer is split into a region per frame in flight. Ranges are
+ * sub-allocated from the region of the current frame, which is fenced at the
+ * end of the frame. A region is only reused once the GPU is done reading it,
+ * so writes never stall on draws nor overwrite data that is still in use.
+ *
+ * With ARB_buffer_storage (GL 4.4) the buffer is persistently and coherently
+ * mapped, so data is written once, directly to memory the GPU reads.
+ * Otherwise each range is mapped unsynchronized, which the fences make safe.
+ *
+ *     TransientRange range = buffer.allocate(size);
+ *     std::memcpy(range.data, vertices, size);
+ *     buffer.commit(range);
+ *
+ * The Context owns a transient buffer, see Context::get_transient_buffer().
+ */
+class TransientBuffer {
+
+public:
+
+    /**
+     * The number of frames the GPU may lag behind, each with its own region.
+     */
+    static const unsigned int FRAME_COUNT = 3;
+
+    TransientBuffer() = delete;
+    TransientBuffer(const TransientBuffer&) = delete;
+    TransientBuffer& operator=(const TransientBuffer&) = delete;
+
+    /**
+     * Creates a buffer with the given size in bytes per frame, which grows
+     * when a frame uses more.
+     */
+    TransientBuffer(unsigned int frameSize);
+
+    /**
+     * Clears resources used by the buffer.
+     */
+    ~TransientBuffer();
+
+    /**
+     * Allocates a range for the current frame and maps it for writing.
+     * Ranges must be committed before the next allocation and before the
+     * draws reading them.
+     *
+     * \param size
+     *     The size of the range in bytes.
+     * \param alignment
+     *     The alignment of the offset of the range, e.g. the size of an index
+     *     or get_uniform_alignment() for uniform blocks.
+     *
+     * \throws std::runtime_error
+     *     If the range could not be mapped.
+     */
+    TransientRange allocate(unsigned int size, unsigned int alignment = 16);
+
+    /**
+     * Makes the data written to a range visible to the GPU. The data of the
+     * range must not be written afterwards.
+     */
+    void commit(const TransientRange& range);
+
+    /**
+     * Allocates a range, copies data into it and commits it.
+     */
+    TransientRange upload(const void* data, unsigned int size, unsigned int alignment = 16);
+
+    /**
+     * Returns the alignment required for the offsets of uniform blocks.
+     */
+    unsigned int get_uniform_alignment() const
+    {
+        return _uniformAlignment;
+    }
+
+    /**
+     * Returns true if the buffer is persistently mapped.
+     */
+    bool is_persistent() const
+    {
+        return _persistent;
+    }
+
+    /**
+     * Returns the size in bytes of the region of each frame.
+     */
+    unsigned int get_frame_size() const
+    {
+        return _frameSize;
+    }
+
+    /**
+     * Returns the number of bytes allocated in the current frame.
+     */
+    unsigned int get_frame_usage() const
+    {
+        return _used;
+    }
+
+private:
+
+    friend class Context;
+
+    /**
+     * An outgrown buffer, deleted once the GPU is done with it.
+     */
+    struct Retired {
+        unsigned int handle;
+        GLsync fence;
+    };
+
+    /**
+     * Creates the buffer and maps it when persistent.
+     */
+    void _create(unsigned int frameSize);
+
+    /**
+     * Replaces the buffer by a larger one, retiring the current buffer.
+     */
+    void _grow(unsigned int size);
+
+    /**
+     * Unmaps the range mapped without persistent mapping.
+     */
+    void _unmap();
+
+    /**
+     * Fences the region of the frame and moves on to the next one, waiting
+     * for the GPU to finish reading it. Called by the context at the end of
+     * every frame.
+     */
+    void _end_frame();
+
+    unsigned int _handle;
+    unsigned char* _mapping;
+    bool _persistent;
+    bool _mapped;
+    unsigned int _frameSize;
+    unsigned int _frame;
+    unsigned int _offset;
+    unsigned int _used;
+    unsigned int _uniformAlignment;
+    GLsync _fences[FRAME_COUNT];
+    std::vector<Retired> _retired;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef _JELLY_UNIFORM_HPP_
+#define _JELLY_UNIFORM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <jelly/math.hpp>
+
+namespace jelly {
+
+class Shader;
+class Texture;
+
+/**
+ * Returns the 32-bit FNV-1a hash of a null-terminated uniform name. Can be
+ * evaluated at compile time.
+ */
+constexpr std::uint32_t uniform_hash(const char* name, std::uint32_t h = 2166136261u)
+{
+    return *name == '\0'
+        ? h
+        : uniform_hash(name + 1, (h ^ (std::uint8_t)*name) * 16777619u);
+}
+
+/**
+ * A uniform name with a precomputed hash. Declaring names as constexpr moves
+ * all hashing to compile time, e.g.
+ *
+ *     constexpr UniformName U_COLOR("u_Color");
+ *     shader.set_uniform_vec4(U_COLOR, color);
+ */
+class UniformName {
+
+public:
+
+    template <std::size_t N>
+    constexpr explicit UniformName(const char (&name)[N]) :
+        _name(name),
+        _hash(uniform_hash(name))
+    {}
+
+    /**
+     * Returns the name of the uniform.
+     */
+    constexpr const char* str() const { return _name; }
+
+    /**
+     * Returns the hash of the name.
+     */
+    constexpr std::uint32_t hash() const { return _hash; }
+
+private:
+
+    const char* _name;
+    std::uint32_t _hash;
+
+};
+
+/**
+ * A typed handle to an active uniform of a Shader, obtained through
+ * Shader::get_uniform(). Default-constructed handles are invalid and setting
+ * them has no effect.
+ *
+ * \note Handles are only valid for the shader that created them.
+ */
+template <typename T>
+class Uniform {
+
+public:
+
+    Uniform() : _location(-1) {}
+
+    /**
+     * Returns the uniform location, or -1 if the handle is invalid.
+     */
+    int get_location() const { return _location; }
+
+    /**
+     * Returns true if the handle refers to an active uniform.
+     */
+    bool is_valid() const { return _location >= 0; }
+
+private:
+
+    friend class Shader;
+
+    explicit Uniform(int location) : _location(location) {}
+
+    int _location;
+
+};
+
+/**
+ * Describes the values of a uniform type, used to validate typed handles.
+ */
+template <typename T> struct UniformTraits;
+
+template <> struct UniformTraits<int>     { enum { COMPONENTS = 1,  INTEGER = 1, SAMPLER = 0 }; };
+template <> struct UniformTraits<float>   { enum { COMPONENTS = 1,  INTEGER = 0, SAMPLER = 0 }; };
+template <> struct UniformTraits<Vec2>    { enum { COMPONENTS = 2,  INTEGER = 0, SAMPLER = 0 }; };
+template <> struct UniformTraits<Vec3>    { enum { COMPONENTS = 3,  INTEGER = 0, SAMPLER = 0 }; };
+template <> struct UniformTraits<Vec4>    { enum { COMPONENTS = 4,  INTEGER = 0, SAMPLER = 0 }; };
+template <> struct UniformTraits<Mat3>    { enum { COMPONENTS = 9,  INTEGER = 0, SAMPLER = 0 }; };
+template <> struct UniformTraits<Mat4>    { enum { COMPONENTS = 16, INTEGER = 0, SAMPLER = 0 }; };
+template <> struct UniformTraits<Texture> { enum { COMPONENTS = 1,  INTEGER = 1, SAMPLER = 1 }; };
+
+}
+
+#endif
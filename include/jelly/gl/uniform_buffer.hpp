@@ -0,0 +1,148 @@
+#ifndef _JELLY_UNIFORM_BUFFER_HPP_
+#define _JELLY_UNIFORM_BUFFER_HPP_
+
+#include <vector>
+
+#include <jelly/math.hpp>
+
+namespace jelly {
+
+/**
+ * Computes member offsets of a uniform block following the GLSL std140 layout
+ * rules. Members must be added in the order they are declared in the block.
+ *
+ *     Std140Layout layout;
+ *     unsigned int projection = layout.add_mat4();
+ *     unsigned int time = layout.add_float();
+ *     UniformBuffer buffer(layout);
+ */
+class Std140Layout {
+
+public:
+
+    Std140Layout() : _size(0) {}
+
+    /**
+     * Adds a float, int or bool member and returns its byte offset.
+     */
+    unsigned int add_float() { return _add(4, 4); }
+
+    unsigned int add_int() { return _add(4, 4); }
+
+    unsigned int add_vec2() { return _add(8, 8); }
+
+    unsigned int add_vec3() { return _add(12, 16); }
+
+    unsigned int add_vec4() { return _add(16, 16); }
+
+    /**
+     * Adds a mat3 member, stored as three vec4 columns, and returns its byte
+     * offset.
+     */
+    unsigned int add_mat3() { return _add(48, 16); }
+
+    unsigned int add_mat4() { return _add(64, 16); }
+
+    /**
+     * Returns the size of the block in bytes, padded to a multiple of 16.
+     */
+    unsigned int get_size() const { return (_size + 15) & ~15u; }
+
+private:
+
+    unsigned int _add(unsigned int size, unsigned int alignment)
+    {
+        unsigned int offset = (_size + alignment - 1) & ~(alignment - 1);
+        _size = offset + size;
+        return offset;
+    }
+
+    unsigned int _size;
+
+};
+
+/**
+ * A uniform buffer object that backs a GLSL uniform block, allowing data that
+ * is shared by many shaders to be uploaded once.
+ *
+ * Values are written to a CPU copy and uploaded with upload(). Bind the buffer
+ * to a binding point with Context::bind_uniform_buffer() and connect shaders
+ * with Shader::set_uniform_block(). Values changing between draws can instead
+ * be streamed with Context::stream_uniform_buffer().
+ */
+class UniformBuffer {
+
+public:
+
+    UniformBuffer() = delete;
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    /**
+     * Creates a buffer large enough for the given block layout.
+     */
+    UniformBuffer(const Std140Layout& layout);
+
+    /**
+     * Creates a buffer of the given size in bytes.
+     */
+    UniformBuffer(unsigned int size);
+
+    /**
+     * Clears resources used by the buffer.
+     */
+    ~UniformBuffer();
+
+    /**
+     * Writes a value at the given byte offset, usually obtained from a
+     * Std140Layout.
+     *
+     * \throw std::runtime_error if the value does not fit in the buffer.
+     */
+    void set_float(unsigned int offset, float);
+
+    void set_int(unsigned int offset, int);
+
+    void set_vec2(unsigned int offset, const Vec2&);
+
+    void set_vec3(unsigned int offset, const Vec3&);
+
+    void set_vec4(unsigned int offset, const Vec4&);
+
+    void set_mat3(unsigned int offset, const Mat3&);
+
+    void set_mat4(unsigned int offset, const Mat4&);
+
+    /**
+     * Uploads the range of values changed since the last upload.
+     */
+    void upload();
+
+    /**
+     * Returns the size of the buffer in bytes.
+     */
+    unsigned int get_size() const { return _data.size(); }
+
+    /**
+     * Returns the CPU copy of the values.
+     */
+    const unsigned char* get_data() const { return _data.data(); }
+
+    /**
+     * Returns the raw OpenGL buffer handle.
+     */
+    unsigned int get_gl_handle() const { return _handle; }
+
+private:
+
+    void _write(unsigned int offset, const void* data, unsigned int size);
+
+    unsigned int _handle;
+    std::vector<unsigned char> _data;
+    unsigned int _dirtyBegin, _dirtyEnd;
+
+};
+
+}
+
+#endif
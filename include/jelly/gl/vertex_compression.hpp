@@ -0,0 +1,155 @@
+#ifndef _JELLY_VERTEX_COMPRESSION_HPP_
+#define _JELLY_VERTEX_COMPRESSION_HPP_
+
+#include <vector>
+
+#include <jelly/gl/vertex_format.hpp>
+#include <jelly/math/mat4.hpp>
+#include <jelly/math/vec2.hpp>
+#include <jelly/math/vec3.hpp>
+
+namespace jelly {
+
+/**
+ * The errors of compressed vertices, measured by decoding them as the GPU
+ * does.
+ */
+struct CompressionReport {
+
+    /**
+     * The largest distance between a position and its decoding, in model
+     * space.
+     */
+    float position_error;
+
+    /**
+     * The largest angle between a normal and its decoding, in radians.
+     */
+    float normal_error;
+
+    /**
+     * The largest distance between a UV and its decoding.
+     */
+    float uv_error;
+
+    /**
+     * The size in bytes of a compressed vertex.
+     */
+    unsigned int vertex_size;
+
+};
+
+
+/**
+ * Selects quantized encodings of the position, normal and UV of mesh
+ * vertices, which reduce the memory and bandwidth they use at a small loss of
+ * precision. The GPU decodes most of them when fetching the attributes:
+ *
+ * - HALF positions are relative to the center of the bounds and UNORM16
+ *   positions to the bounds, both undone by the mesh's position transform,
+ *   which must be applied after the model matrix, i.e.
+ *   `model * mesh.get_position_transform()`.
+ * - OCTAHEDRAL normals are 2D vectors of integers, read as vec2 and decoded
+ *   with the `jelly_decode_octahedral16` or `jelly_decode_octahedral8`
+ *   functions of DECODE_GLSL, which match the CPU decoding.
+ * - UNORM16 UVs are clamped to [0, 1], use HALF for repeating textures.
+ *
+ * The compressed vertices use the standard locations, 0 for the position, 1
+ * for the normal and 2 for the UV, in a single stream.
+ */
+class VertexCompression {
+
+public:
+
+    enum class Position {
+        FLOAT,
+        HALF,
+        UNORM16
+    };
+
+    enum class Normal {
+        FLOAT,
+        OCTAHEDRAL16,
+        OCTAHEDRAL8
+    };
+
+    enum class Uv {
+        FLOAT,
+        HALF,
+        UNORM16
+    };
+
+    /**
+     * GLSL source of `vec3 jelly_decode_octahedral16(vec2 q)` and
+     * `vec3 jelly_decode_octahedral8(vec2 q)`, which decode the integer
+     * normals, and of `vec3 jelly_decode_octahedral(vec2 e)` for vectors in
+     * [-1, 1]. To insert after the #version line of vertex shaders reading
+     * octahedral normals.
+     */
+    static const char* const DECODE_GLSL;
+
+    /**
+     * Selects the encodings, which default to uncompressed floats.
+     */
+    VertexCompression(
+        Position position = Position::FLOAT,
+        Normal normal = Normal::FLOAT,
+        Uv uv = Uv::FLOAT
+    );
+
+    /**
+     * Returns the format of the compressed vertices.
+     */
+    VertexFormat get_format() const;
+
+    /**
+     * Compresses vertices into the interleaved data of get_format().
+     *
+     * \param vertices
+     *     The vector of vertices.
+     * \param normals
+     *     The vector of unit vertex normals, equal in length to `vertices`.
+     * \param uvs
+     *     The vector of UV coordinates, equal in length to `vertices`.
+     * \param positionTransform
+     *     Set to the matrix which decodes the positions.
+     * \param report
+     *     If not null, set to the errors of the compressed vertices.
+     *
+     * \throws std::runtime_error
+     *     If the vectors differ in length.
+     */
+    std::vector<unsigned char> compress(
+        const std::vector<Vec3>& vertices,
+        const std::vector<Vec3>& normals,
+        const std::vector<Vec2>& uvs,
+        Mat4& positionTransform,
+        CompressionReport* report = nullptr
+    ) const;
+
+    Position get_position() const
+    {
+        return _position;
+    }
+
+    Normal get_normal() const
+    {
+        return _normal;
+    }
+
+    Uv get_uv() const
+    {
+        return _uv;
+    }
+
+private:
+
+    Position _position;
+    Normal _normal;
+    Uv _uv;
+
+};
+
+}
+
+#endif
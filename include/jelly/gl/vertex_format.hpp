@@ -0,0 +1,205 @@
+#ifndef _JELLY_VERTEX_FORMAT_HPP_
+#define _JELLY_VERTEX_FORMAT_HPP_
+
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace jelly {
+
+/**
+ * Describes the layout of mesh vertices as a list of attributes, stored in
+ * one or more streams (vertex buffers).
+ *
+ * Attributes are laid out in each stream in the order they are added, each
+ * aligned to its component size, and the vertices are padded to a multiple of
+ * 4 bytes, which drivers may require, e.g. a position+color format:
+ *
+ *     VertexFormat format;
+ *     format.add(0, 3, VertexFormat::Type::FLOAT)
+ *           .add(3, 4, VertexFormat::Type::UNSIGNED_BYTE, true);
+ *
+ * By convention the position is at location 0, the normal at 1 and the UV at
+ * 2, which is what the standard format and the built-in shaders use.
+ */
+class VertexFormat {
+
+public:
+
+    /**
+     * Component types.
+     */
+    enum class Type {
+        FLOAT = GL_FLOAT,
+        HALF_FLOAT = GL_HALF_FLOAT,
+        BYTE = GL_BYTE,
+        UNSIGNED_BYTE = GL_UNSIGNED_BYTE,
+        SHORT = GL_SHORT,
+        UNSIGNED_SHORT = GL_UNSIGNED_SHORT,
+        INT = GL_INT,
+        UNSIGNED_INT = GL_UNSIGNED_INT,
+
+        /**
+         * 4 components packed into 32 bits, 10 bits each for xyz and 2 for w.
+         */
+        INT_2_10_10_10_REV = GL_INT_2_10_10_10_REV,
+        UNSIGNED_INT_2_10_10_10_REV = GL_UNSIGNED_INT_2_10_10_10_REV
+    };
+
+    /**
+     * A vertex attribute.
+     */
+    struct Attribute {
+
+        /**
+         * The shader attribute location.
+         */
+        unsigned int location;
+
+        /**
+         * The number of components, from 1 to 4.
+         */
+        unsigned int components;
+
+        Type type;
+
+        /**
+         * Whether integer types map to [0, 1] or [-1, 1] instead of their
+         * values, e.g. for colors.
+         */
+        bool normalized;
+
+        /**
+         * Whether the components are read as integers by the shader, e.g. for
+         * int or uvec4 inputs, instead of being converted to floats.
+         */
+        bool integer;
+
+        /**
+         * The index of the stream holding the attribute.
+         */
+        unsigned int stream;
+
+        /**
+         * The byte offset of the attribute in its stream's vertices.
+         */
+        unsigned int offset;
+
+    };
+
+    /**
+     * The {x y z nx ny nz u v} float format, in a single stream.
+     */
+    static VertexFormat standard();
+
+    /**
+     * Creates a format without attributes.
+     */
+    VertexFormat();
+
+    /**
+     * Adds an attribute after the others of its stream.
+     *
+     * \param location
+     *     The shader attribute location.
+     * \param components
+     *     The number of components, from 1 to 4, or 4 for packed types.
+     * \param type
+     *     The component type.
+     * \param normalized
+     *     Whether integer types are normalized.
+     * \param stream
+     *     The stream index. Streams must be used in order, without gaps.
+     *
+     * \throws std::runtime_error
+     *     If the attribute is invalid or its location is already used.
+     */
+    VertexFormat& add(
+        unsigned int location,
+        unsigned int components,
+        Type type,
+        bool normalized = false,
+        unsigned int stream = 0
+    );
+
+    /**
+     * Adds an attribute read as integers by the shader, for int, ivec or
+     * uvec inputs such as indices or flags, after the others of its stream.
+     *
+     * \throws std::runtime_error
+     *     If the attribute is invalid, its type is not an integer type or its
+     *     location is already used.
+     */
+    VertexFormat& add_integer(
+        unsigned int location,
+        unsigned int components,
+        Type type,
+        unsigned int stream = 0
+    );
+
+    /**
+     * Adds a float matrix as consecutive attributes, one per column, from
+     * location on, as GLSL lays out matrix attributes, e.g. 4 columns of 4
+     * rows for a mat4. An affine transform is better passed as 3 columns of
+     * 4, the rows of its 3x4 matrix, and rebuilt by the shader.
+     *
+     * \throws std::runtime_error
+     *     If an attribute is invalid or its location is already used.
+     */
+    VertexFormat& add_matrix(
+        unsigned int location,
+        unsigned int columns,
+        unsigned int rows,
+        unsigned int stream = 0
+    );
+
+    /**
+     * Returns the attributes in the order they were added.
+     */
+    const std::vector<Attribute>& get_attributes() const
+    {
+        return _attributes;
+    }
+
+    /**
+     * Returns the attribute at a location, or nullptr if there is none.
+     */
+    const Attribute* get_attribute(unsigned int location) const;
+
+    /**
+     * Returns the number of streams.
+     */
+    unsigned int get_stream_count() const
+    {
+        return _strides.size();
+    }
+
+    /**
+     * Returns the size in bytes of a vertex in a stream.
+     */
+    unsigned int get_stride(unsigned int stream) const
+    {
+        return (_strides[stream] + 3) & ~3u;
+    }
+
+    /**
+     * Returns the size in bytes of a vertex across all streams.
+     */
+    unsigned int get_vertex_size() const;
+
+    /**
+     * Returns the size in bytes of a component type.
+     */
+    static unsigned int type_size(Type type);
+
+private:
+
+    std::vector<Attribute> _attributes;
+    // The end of the last attribute of each stream, before padding
+    std::vector<unsigned int> _strides;
+
+};
+
+}
+
+#endif
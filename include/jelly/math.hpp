@@ -2,10 +2,13 @@
 #define _JELLY_MATH_HPP_
 
 #include <jelly/math/common.hpp>
-#include <jelly/math/vec2.hpp>
-#include <jelly/math/vec3.hpp>
-#include <jelly/math/vec4.hpp>
-#include <jelly/math/mat3.hpp>
-#include <jelly/math/mat4.hpp>
+#include <jelly/math/vec.hpp>
+#include <jelly/math/mat.hpp>
+#include <jelly/math/quat.hpp>
+#include <jelly/math/bounds.hpp>
+#include <jelly/math/frustum.hpp>
+#include <jelly/math/packing.hpp>
+#include <jelly/math/simd.hpp>
+#include <jelly/math/transform.hpp>
 
 #endif
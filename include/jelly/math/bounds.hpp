@@ -0,0 +1,125 @@
+#ifndef _JELLY_MATH_BOUNDS_HPP_
+#define _JELLY_MATH_BOUNDS_HPP_
+
+#include <cmath>
+#include <limits>
+
+#include <jelly/math/mat.hpp>
+#include <jelly/math/vec.hpp>
+
+namespace jelly {
+
+/**
+ * An axis-aligned bounding box.
+ */
+struct Aabb {
+
+    /**
+     * Creates an empty box, which contains nothing until expanded.
+     */
+    constexpr Aabb() :
+        min(std::numeric_limits<float>::infinity()),
+        max(-std::numeric_limits<float>::infinity())
+    {}
+
+    constexpr Aabb(const Vec3& min, const Vec3& max) : min(min), max(max) {}
+
+    /**
+     * Returns true if the box contains nothing.
+     */
+    constexpr bool is_empty() const
+    {
+        return min.x() > max.x() || min.y() > max.y() || min.z() > max.z();
+    }
+
+    constexpr Vec3 center() const { return 0.5f * (min + max); }
+
+    /**
+     * Returns the half-size of the box along each axis.
+     */
+    constexpr Vec3 extent() const { return 0.5f * (max - min); }
+
+    /**
+     * Grows the box to contain a point.
+     */
+    constexpr void expand(const Vec3& p)
+    {
+        for (std::size_t i = 0; i < 3; ++i) {
+            min[i] = p[i] < min[i] ? p[i] : min[i];
+            max[i] = p[i] > max[i] ? p[i] : max[i];
+        }
+    }
+
+    /**
+     * Grows the box to contain another box.
+     */
+    constexpr void expand(const Aabb& box)
+    {
+        expand(box.min);
+        expand(box.max);
+    }
+
+    Vec3 min;
+    Vec3 max;
+
+};
+
+
+/**
+ * A bounding sphere.
+ */
+struct Sphere {
+
+    constexpr Sphere() : center(), radius(0.0f) {}
+
+    constexpr Sphere(const Vec3& center, float radius) : center(center), radius(radius) {}
+
+    Vec3 center;
+    float radius;
+
+};
+
+
+/**
+ * Returns the axis-aligned box containing a transformed box, which may be
+ * larger than the transformed box itself under rotation.
+ */
+constexpr Aabb transform(const Mat4& m, const Aabb& box)
+{
+    // The extent grows by the absolute values of the rotation and scale, see
+    // J. Arvo, "Transforming Axis-Aligned Bounding Boxes"
+    Vec3 c = box.center();
+    Vec3 e = box.extent();
+    Vec3 center;
+    Vec3 extent;
+    for (std::size_t r = 0; r < 3; ++r) {
+        center[r] = m(r, 3);
+        for (std::size_t k = 0; k < 3; ++k) {
+            float a = m(r, k);
+            center[r] += a * c[k];
+            extent[r] += (a < 0.0f ? -a : a) * e[k];
+        }
+    }
+    return Aabb(center - extent, center + extent);
+}
+
+/**
+ * Returns the sphere containing a transformed sphere, scaled by the largest
+ * scale of the matrix.
+ */
+inline Sphere transform(const Mat4& m, const Sphere& sphere)
+{
+    Vec3 center = (m * Vec4(sphere.center, 1.0f)).xyz();
+    float scale = 0.0f;
+    for (std::size_t k = 0; k < 3; ++k) {
+        Vec3 axis(m(0, k), m(1, k), m(2, k));
+        if (dot(axis, axis) > scale) {
+            scale = dot(axis, axis);
+        }
+    }
+    return Sphere(center, sphere.radius * std::sqrt(scale));
+}
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef _JELLY_MATH_FRUSTUM_HPP_
+#define _JELLY_MATH_FRUSTUM_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <jelly/math/bounds.hpp>
+#include <jelly/math/mat.hpp>
+#include <jelly/math/vec.hpp>
+
+namespace jelly {
+
+/**
+ * A view frustum as 6 planes facing inwards, used to cull bounding volumes
+ * outside of the view.
+ *
+ * The tests are conservative: a volume outside of the frustum near one of its
+ * edges or corners may still be reported as intersecting it, which only costs
+ * a draw.
+ */
+class Frustum {
+
+public:
+
+    /**
+     * Creates a frustum that contains everything.
+     */
+    constexpr Frustum() :
+        _planes{Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f),
+                Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f),
+                Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f)}
+    {}
+
+    /**
+     * Extracts the frustum of a projection * view matrix, in world space. A
+     * projection * view * model matrix gives the frustum in model space.
+     */
+    explicit Frustum(const Mat4& m)
+    {
+        // The planes are sums of the rows of the matrix, see G. Gribb and
+        // K. Hartmann, "Fast Extraction of Viewing Frustum Planes from the
+        // World-View-Projection Matrix"
+        for (std::size_t i = 0; i < 6; ++i) {
+            float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+            std::size_t row = i / 2;
+            Vec4 plane;
+            for (std::size_t c = 0; c < 4; ++c) {
+                plane[c] = m(3, c) + sign * m(row, c);
+            }
+            _planes[i] = (1.0f / magnitude(plane.xyz())) * plane;
+        }
+    }
+
+    /**
+     * Returns a plane as (normal, distance), in the order left, right,
+     * bottom, top, near and far. A point p is inside the plane when
+     * dot(normal, p) + distance >= 0.
+     */
+    constexpr const Vec4& get_plane(std::size_t i) const { return _planes[i]; }
+
+    /**
+     * Returns true if the point is inside the frustum.
+     */
+    constexpr bool contains(const Vec3& p) const
+    {
+        for (std::size_t i = 0; i < 6; ++i) {
+            if (!(dot(_planes[i].xyz(), p) + _planes[i].w() >= 0.0f)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Returns true if the sphere may intersect the frustum.
+     */
+    constexpr bool intersects(const Sphere& sphere) const
+    {
+        for (std::size_t i = 0; i < 6; ++i) {
+            float d = dot(_planes[i].xyz(), sphere.center) + _planes[i].w() + sphere.radius;
+            if (!(d >= 0.0f)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Returns true if the box may intersect the frustum.
+     */
+    constexpr bool intersects(const Aabb& box) const
+    {
+        for (std::size_t i = 0; i < 6; ++i) {
+            // Test the corner furthest along the normal
+            Vec3 n = _planes[i].xyz();
+            Vec3 p(
+                n.x() >= 0.0f ? box.max.x() : box.min.x(),
+                n.y() >= 0.0f ? box.max.y() : box.min.y(),
+                n.z() >= 0.0f ? box.max.z() : box.min.z()
+            );
+            if (!(dot(n, p) + _planes[i].w() >= 0.0f)) return false;
+        }
+        return true;
+    }
+
+private:
+
+    Vec4 _planes[6];
+
+};
+
+
+/*
+ * Batch culling of arrays of bounding volumes against a frustum, testing 4
+ * volumes at a time with the SIMD kernels of the library.
+ */
+
+/**
+ * Writes 1 to visible[i] if volume i may intersect the frustum and 0
+ * otherwise.
+ */
+void cull(const Frustum& frustum, const Sphere* spheres, std::size_t count, std::uint8_t* visible);
+
+void cull(const Frustum& frustum, const Aabb* boxes, std::size_t count, std::uint8_t* visible);
+
+/**
+ * Writes the indices of the volumes that may intersect the frustum, in
+ * increasing order, and returns how many were written.
+ *
+ * \param indices
+ *     The output, with room for up to count indices.
+ */
+std::size_t cull_indices(const Frustum& frustum, const Sphere* spheres, std::size_t count,
+                         std::uint32_t* indices);
+
+std::size_t cull_indices(const Frustum& frustum, const Aabb* boxes, std::size_t count,
+                         std::uint32_t* indices);
+
+}
+
+#endif
@@ -0,0 +1,655 @@
+#ifndef _JELLY_MATH_MAT_HPP_
+#define _JELLY_MATH_MAT_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include <jelly/math/simd_ops.hpp>
+#include <jelly/math/vec.hpp>
+
+namespace jelly {
+
+/**
+ * An NxN column-major matrix of T, usable in constant expressions.
+ *
+ * The common instantiations are named Mat3 and Mat4 for float, and Mat3d and
+ * Mat4d for double. 4x4 float matrices are aligned to 16 bytes for SIMD
+ * loads.
+ */
+template <std::size_t N, typename T>
+class alignas((N == 4 && sizeof(T) == 4) ? 16 : alignof(T)) Mat {
+
+    static_assert(N >= 2, "Matrices need at least 2 rows");
+
+public:
+
+    typedef T value_type;
+
+    /**
+     * Creates a perspective projection matrix.
+     *
+     * \param fov
+     *     The field of view of the projection in radians.
+     * \param ratio
+     *     The aspect ratio of the viewport (width / height).
+     * \param near
+     *     The near cut-off distance.
+     * \param far
+     *     The far cut-off distance.
+     */
+    static Mat perspective(T fov, T ratio, T n, T f)
+    {
+        static_assert(N == 4, "Projections are 4x4 matrices");
+        T t = n * std::tan(fov * T(0.5));
+        T b = -t;
+        T r = t * ratio;
+        T l = -r;
+        const T m[] = {
+             T(2)*n/(r-l),   T(0),            T(0),           T(0),
+             T(0),           T(2)*n/(t-b),    T(0),           T(0),
+             T(0),           T(0),           -(f+n)/(f-n),   T(-1),
+            -n*(r+l)/(r-l), -n*(t+b)/(t-b),   T(2)*f*n/(n-f), T(0)
+        };
+        return Mat(m);
+    }
+
+    /**
+     * Creates an orthographic projection matrix.
+     *
+     * \param l
+     *     The left side of the projection cube.
+     * \param r
+     *     The right side of the projection cube.
+     * \param b
+     *     The bottom of the projection cube.
+     * \param t
+     *     The top of the projection cube.
+     * \param n
+     *     The near side of the projection cube.
+     * \param f
+     *     The far side of the projection cube.
+     */
+    static constexpr Mat orthographic(T l, T r, T b, T t, T n, T f)
+    {
+        static_assert(N == 4, "Projections are 4x4 matrices");
+        const T m[] = {
+             T(2)/(r-l),   T(0),         T(0),        T(0),
+             T(0),         T(2)/(t-b),   T(0),        T(0),
+             T(0),         T(0),        -T(2)/(f-n),  T(0),
+            -(r+l)/(r-l), -(t+b)/(t-b), -(f+n)/(f-n), T(1)
+        };
+        return Mat(m);
+    }
+
+    /**
+     * Creates a look-at matrix.
+     *
+     * \param origin
+     *     The point at which the object is located.
+     * \param target
+     *     The point at which the look-at matrix must look.
+     * \param up
+     *     The up direction of the world, usually [0 1 0].
+     */
+    static Mat look_at(const Vec<3, T>& origin, const Vec<3, T>& target, const Vec<3, T>& up)
+    {
+        static_assert(N == 4, "Look-at matrices are 4x4 matrices");
+        Vec<3, T> dir = normalize(origin - target);
+        Vec<3, T> right = normalize(cross(up, dir));
+        Vec<3, T> new_up = cross(dir, right);
+
+        Mat rotation;
+        rotation(0, 0) = right.x();
+        rotation(0, 1) = right.y();
+        rotation(0, 2) = right.z();
+        rotation(1, 0) = new_up.x();
+        rotation(1, 1) = new_up.y();
+        rotation(1, 2) = new_up.z();
+        rotation(2, 0) = dir.x();
+        rotation(2, 1) = dir.y();
+        rotation(2, 2) = dir.z();
+        rotation(3, 3) = T(1);
+
+        return rotation * Mat::translation(-origin);
+    }
+
+    /**
+     * Creates a translation matrix.
+     *
+     * \param t
+     *     The translation vector.
+     */
+    static constexpr Mat translation(const Vec<3, T>& t)
+    {
+        static_assert(N == 4, "Translations are 4x4 matrices");
+        Mat m(T(1));
+        m(0, 3) = t.x();
+        m(1, 3) = t.y();
+        m(2, 3) = t.z();
+        return m;
+    }
+
+    /**
+     * Creates an x rotation matrix.
+     *
+     * \param a
+     *     The x rotation angle in radians.
+     */
+    static Mat x_rotation(T a)
+    {
+        static_assert(N == 4, "Rotations are 4x4 matrices");
+        T cs = std::cos(a);
+        T sn = std::sin(a);
+        Mat m(T(1));
+        m(1, 1) = cs;
+        m(2, 1) = sn;
+        m(1, 2) = -sn;
+        m(2, 2) = cs;
+        return m;
+    }
+
+    /**
+     * Creates a y rotation matrix.
+     *
+     * \param a
+     *     The y rotation angle in radians.
+     */
+    static Mat y_rotation(T a)
+    {
+        static_assert(N == 4, "Rotations are 4x4 matrices");
+        T cs = std::cos(a);
+        T sn = std::sin(a);
+        Mat m(T(1));
+        m(0, 0) = cs;
+        m(2, 0) = -sn;
+        m(0, 2) = sn;
+        m(2, 2) = cs;
+        return m;
+    }
+
+    /**
+     * Creates a z rotation matrix.
+     *
+     * \param a
+     *     The z rotation angle in radians.
+     */
+    static Mat z_rotation(T a)
+    {
+        static_assert(N == 4, "Rotations are 4x4 matrices");
+        T cs = std::cos(a);
+        T sn = std::sin(a);
+        Mat m(T(1));
+        m(0, 0) = cs;
+        m(1, 0) = sn;
+        m(0, 1) = -sn;
+        m(1, 1) = cs;
+        return m;
+    }
+
+    /**
+     * Creates a scaling matrix.
+     *
+     * \param s
+     *     The scale to apply per axis.
+     */
+    static constexpr Mat scale(const Vec<3, T>& s)
+    {
+        static_assert(N == 4, "Scaling matrices are 4x4 matrices");
+        Mat m(T(1));
+        m(0, 0) = s.x();
+        m(1, 1) = s.y();
+        m(2, 2) = s.z();
+        return m;
+    }
+
+    /**
+     * Creates a zero matrix.
+     */
+    constexpr Mat() : _data{} {}
+
+    /**
+     * Creates a diagonal matrix with all diagonals set to the provided value.
+     */
+    constexpr Mat(T d) : _data{}
+    {
+        for (std::size_t i = 0; i < N; ++i) _data[i*N+i] = d;
+    }
+
+    /**
+     * Creates a matrix from the given array of N*N values.
+     *
+     * \note The array must be in column-major form.
+     */
+    constexpr Mat(const T* m) : _data{}
+    {
+        for (std::size_t i = 0; i < N*N; ++i) _data[i] = m[i];
+    }
+
+    /**
+     * Creates a matrix containing the smaller matrix as its top-left part and
+     * w at position (N-1, N-1).
+     */
+    template <std::size_t M = N, typename = typename std::enable_if<(M >= 3)>::type>
+    constexpr Mat(const Mat<M-1, T>& m, T w = T(1)) : _data{}
+    {
+        for (std::size_t c = 0; c < N-1; ++c) {
+            for (std::size_t r = 0; r < N-1; ++r) {
+                _data[N*c+r] = m(r, c);
+            }
+        }
+        _data[N*N-1] = w;
+    }
+
+    /**
+     * Returns a pointer to the matrix.
+     *
+     * \note The array is in column-major form.
+     */
+    constexpr T* data() { return _data; }
+
+    constexpr T& operator()(std::size_t r, std::size_t c) { return _data[N*c+r]; }
+    constexpr T operator()(std::size_t r, std::size_t c) const { return _data[N*c+r]; }
+
+    constexpr T& operator[](std::size_t i) { return _data[i]; }
+    constexpr T operator[](std::size_t i) const { return _data[i]; }
+
+    /**
+     * Returns a pointer to the matrix.
+     *
+     * \note the array is in column-major form.
+     */
+    constexpr const T* data() const { return _data; }
+
+private:
+
+    T _data[N*N];
+
+};
+
+typedef Mat<3, float> Mat3;
+typedef Mat<4, float> Mat4;
+
+typedef Mat<3, double> Mat3d;
+typedef Mat<4, double> Mat4d;
+
+
+namespace detail {
+
+template <std::size_t N, typename T>
+constexpr Mat<N, T> multiply(const Mat<N, T>& a, const Mat<N, T>& b)
+{
+    Mat<N, T> result;
+    for (std::size_t c = 0; c < N; ++c) {
+        for (std::size_t r = 0; r < N; ++r) {
+            T sum = a(r, 0) * b(0, c);
+            for (std::size_t k = 1; k < N; ++k) sum += a(r, k) * b(k, c);
+            result(r, c) = sum;
+        }
+    }
+    return result;
+}
+
+template <std::size_t N, typename T>
+constexpr Vec<N, T> transform(const Mat<N, T>& m, const Vec<N, T>& v)
+{
+    Vec<N, T> result;
+    for (std::size_t r = 0; r < N; ++r) {
+        T sum = m(r, 0) * v[0];
+        for (std::size_t k = 1; k < N; ++k) sum += m(r, k) * v[k];
+        result[r] = sum;
+    }
+    return result;
+}
+
+template <typename T>
+constexpr Mat<3, T> transposed_inverse(const Mat<3, T>& m)
+{
+    // The cofactor matrix divided by the determinant
+    Mat<3, T> result;
+    result(0, 0) = + (m(1, 1) * m(2, 2) - m(2, 1) * m(1, 2));
+    result(1, 0) = - (m(0, 1) * m(2, 2) - m(2, 1) * m(0, 2));
+    result(2, 0) = + (m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2));
+    result(0, 1) = - (m(1, 0) * m(2, 2) - m(2, 0) * m(1, 2));
+    result(1, 1) = + (m(0, 0) * m(2, 2) - m(2, 0) * m(0, 2));
+    result(2, 1) = - (m(0, 0) * m(1, 2) - m(1, 0) * m(0, 2));
+    result(0, 2) = + (m(1, 0) * m(2, 1) - m(2, 0) * m(1, 1));
+    result(1, 2) = - (m(0, 0) * m(2, 1) - m(2, 0) * m(0, 1));
+    result(2, 2) = + (m(0, 0) * m(1, 1) - m(1, 0) * m(0, 1));
+
+    T inv = T(1) / (m(0, 0) * result(0, 0) + m(1, 0) * result(1, 0) + m(2, 0) * result(2, 0));
+    for (std::size_t i = 0; i < 9; ++i) result[i] *= inv;
+    return result;
+}
+
+template <typename T>
+constexpr Mat<4, T> inverse(const Mat<4, T>& m)
+{
+    // With a, b, c and d the upper 3 rows of the columns and x, y, z and w
+    // the bottom row, the cofactors reduce to cross and dot products, see
+    // E. Lengyel, "Foundations of Game Engine Development", vol. 1
+    Vec<3, T> a(m(0, 0), m(1, 0), m(2, 0));
+    Vec<3, T> b(m(0, 1), m(1, 1), m(2, 1));
+    Vec<3, T> c(m(0, 2), m(1, 2), m(2, 2));
+    Vec<3, T> d(m(0, 3), m(1, 3), m(2, 3));
+    T x = m(3, 0);
+    T y = m(3, 1);
+    T z = m(3, 2);
+    T w = m(3, 3);
+
+    Vec<3, T> s = cross(a, b);
+    Vec<3, T> t = cross(c, d);
+    Vec<3, T> u = y * a - x * b;
+    Vec<3, T> v = w * c - z * d;
+
+    T inv = T(1) / (dot(s, v) + dot(t, u));
+    s = inv * s;
+    t = inv * t;
+    u = inv * u;
+    v = inv * v;
+
+    const Vec<3, T> rows[] = {
+        cross(b, v) + y * t,
+        cross(v, a) - x * t,
+        cross(d, u) + w * s,
+        cross(u, c) - z * s
+    };
+    Mat<4, T> result;
+    for (std::size_t r = 0; r < 4; ++r) {
+        for (std::size_t i = 0; i < 3; ++i) {
+            result(r, i) = rows[r][i];
+        }
+    }
+    result(0, 3) = -dot(b, t);
+    result(1, 3) = dot(a, t);
+    result(2, 3) = -dot(d, s);
+    result(3, 3) = dot(c, s);
+    return result;
+}
+
+/*
+ * The SIMD kernels, defined inline in jelly/math/mat_simd.hpp so that they
+ * inline into user code, and checked against the templates above when
+ * simd::set_verify() is enabled.
+ */
+inline namespace JELLY_SIMD_NAMESPACE {
+inline void mat3_multiply(const float* a, const float* b, float* o);
+inline void mat3_transform(const float* m, const float* v, float* o);
+inline void mat3_transposed_inverse(const float* m, float* o);
+inline void mat4_multiply(const float* a, const float* b, float* o);
+inline void mat4_transform(const float* m, const float* v, float* o);
+inline void mat4_inverse(const float* m, float* o);
+inline void mat4_scale(const float* m, float s, float* o);
+}
+
+}
+
+
+/**
+ * Matrix multiplication.
+ */
+template <std::size_t N, typename T>
+constexpr Mat<N, T> operator*(const Mat<N, T>& m1, const Mat<N, T>& m2)
+{
+    return detail::multiply(m1, m2);
+}
+
+constexpr Mat4 operator*(const Mat4& m1, const Mat4& m2)
+{
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+    if (!__builtin_is_constant_evaluated()) {
+        Mat4 result;
+        detail::mat4_multiply(m1.data(), m2.data(), result.data());
+        return result;
+    }
+#endif
+    return detail::multiply(m1, m2);
+}
+
+constexpr Mat3 operator*(const Mat3& m1, const Mat3& m2)
+{
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+    if (!__builtin_is_constant_evaluated()) {
+        Mat3 result;
+        detail::mat3_multiply(m1.data(), m2.data(), result.data());
+        return result;
+    }
+#endif
+    return detail::multiply(m1, m2);
+}
+
+/**
+ * Vector-matrix multiplication.
+ */
+template <std::size_t N, typename T>
+constexpr Vec<N, T> operator*(const Mat<N, T>& m, const Vec<N, T>& v)
+{
+    return detail::transform(m, v);
+}
+
+constexpr Vec4 operator*(const Mat4& m, const Vec4& v)
+{
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+    if (!__builtin_is_constant_evaluated()) {
+        Vec4 result;
+        detail::mat4_transform(m.data(), v.data(), result.data());
+        return result;
+    }
+#endif
+    return detail::transform(m, v);
+}
+
+constexpr Vec3 operator*(const Mat3& m, const Vec3& v)
+{
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+    if (!__builtin_is_constant_evaluated()) {
+        Vec3 result;
+        detail::mat3_transform(m.data(), v.data(), result.data());
+        return result;
+    }
+#endif
+    return detail::transform(m, v);
+}
+
+/**
+ * Scalar-matrix multiplication.
+ */
+template <std::size_t N, typename T>
+constexpr Mat<N, T> operator*(typename Mat<N, T>::value_type s, const Mat<N, T>& m)
+{
+    Mat<N, T> result;
+    for (std::size_t i = 0; i < N*N; ++i) result[i] = s * m[i];
+    return result;
+}
+
+constexpr Mat4 operator*(float s, const Mat4& m)
+{
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+    if (!__builtin_is_constant_evaluated()) {
+        Mat4 result;
+        detail::mat4_scale(m.data(), s, result.data());
+        return result;
+    }
+#endif
+    Mat4 result;
+    for (std::size_t i = 0; i < 16; ++i) result[i] = s * m[i];
+    return result;
+}
+
+/**
+ * Matrix-scalar multiplication.
+ */
+template <std::size_t N, typename T>
+constexpr Mat<N, T> operator*(const Mat<N, T>& m, typename Mat<N, T>::value_type s)
+{
+    Mat<N, T> result;
+    for (std::size_t i = 0; i < N*N; ++i) result[i] = m[i] * s;
+    return result;
+}
+
+constexpr Mat4 operator*(const Mat4& m, float s)
+{
+    return s * m;
+}
+
+/**
+ * Element-wise equality.
+ */
+template <std::size_t N, typename T>
+constexpr bool operator==(const Mat<N, T>& a, const Mat<N, T>& b)
+{
+    for (std::size_t i = 0; i < N*N; ++i) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+template <std::size_t N, typename T>
+constexpr bool operator!=(const Mat<N, T>& a, const Mat<N, T>& b)
+{
+    return !(a == b);
+}
+
+/**
+ * Returns the transpose of the matrix.
+ */
+template <std::size_t N, typename T>
+constexpr Mat<N, T> transpose(const Mat<N, T>& m)
+{
+    Mat<N, T> result;
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+            result(j, i) = m(i, j);
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns the (N-1)x(N-1) top-left part of the matrix.
+ */
+template <std::size_t N, typename T>
+constexpr Mat<N-1, T> topleft(const Mat<N, T>& m)
+{
+    Mat<N-1, T> result;
+    for (std::size_t c = 0; c < N-1; ++c) {
+        for (std::size_t r = 0; r < N-1; ++r) {
+            result(r, c) = m(r, c);
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns the determinant of the matrix.
+ */
+template <typename T>
+constexpr T determinant(const Mat<3, T>& m)
+{
+    T d1 = m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1));
+    T d2 = m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0));
+    T d3 = m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+    return d1 - d2 + d3;
+}
+
+/**
+ * Returns the transposed inverse of the matrix.
+ *
+ * \note The matrix is assumed to be invertible.
+ */
+template <typename T>
+constexpr Mat<3, T> transposed_inverse(const Mat<3, T>& m)
+{
+    return detail::transposed_inverse(m);
+}
+
+constexpr Mat3 transposed_inverse(const Mat3& m)
+{
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+    if (!__builtin_is_constant_evaluated()) {
+        Mat3 result;
+        detail::mat3_transposed_inverse(m.data(), result.data());
+        return result;
+    }
+#endif
+    return detail::transposed_inverse(m);
+}
+
+/**
+ * Returns the inverse of the matrix.
+ *
+ * Prefer affine_inverse() or rigid_inverse() when the matrix is known to be
+ * of that form, e.g. model and view matrices, as they are cheaper and more
+ * accurate.
+ *
+ * \note The matrix is assumed to be invertible.
+ */
+template <typename T>
+constexpr Mat<4, T> inverse(const Mat<4, T>& m)
+{
+    return detail::inverse(m);
+}
+
+constexpr Mat4 inverse(const Mat4& m)
+{
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+    if (!__builtin_is_constant_evaluated()) {
+        Mat4 result;
+        detail::mat4_inverse(m.data(), result.data());
+        return result;
+    }
+#endif
+    return detail::inverse(m);
+}
+
+/**
+ * Returns the inverse of an affine transformation, i.e. a matrix with a
+ * bottom row of [0 0 0 1], such as a model matrix with scaling.
+ *
+ * \note The matrix is assumed to be invertible.
+ */
+template <typename T>
+constexpr Mat<4, T> affine_inverse(const Mat<4, T>& m)
+{
+    // The inverse of [A t] is [A^-1 -A^-1*t]
+    Mat<3, T> a = transpose(transposed_inverse(topleft(m)));
+    Vec<3, T> t = a * Vec<3, T>(m(0, 3), m(1, 3), m(2, 3));
+    Mat<4, T> result(a);
+    result(0, 3) = -t.x();
+    result(1, 3) = -t.y();
+    result(2, 3) = -t.z();
+    return result;
+}
+
+/**
+ * Returns the inverse of a rigid transformation, i.e. only rotation and
+ * translation such as a camera or look-at matrix.
+ */
+template <typename T>
+constexpr Mat<4, T> rigid_inverse(const Mat<4, T>& m)
+{
+    // The inverse of a rotation is its transpose
+    Mat<3, T> r = transpose(topleft(m));
+    Vec<3, T> t = r * Vec<3, T>(m(0, 3), m(1, 3), m(2, 3));
+    Mat<4, T> result(r);
+    result(0, 3) = -t.x();
+    result(1, 3) = -t.y();
+    result(2, 3) = -t.z();
+    return result;
+}
+
+/**
+ * Returns the transposed inverse of the 3x3 top-left part of the matrix. Used
+ * for normal transform calculations.
+ */
+template <typename T>
+constexpr Mat<3, T> normal_matrix(const Mat<4, T>& m)
+{
+    return transposed_inverse(topleft(m));
+}
+
+}
+
+#include <jelly/math/mat_simd.hpp>
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef _JELLY_MATH_MAT_SIMD_HPP_
+#define _JELLY_MATH_MAT_SIMD_HPP_
+
+#include <jelly/math/mat.hpp>
+#include <jelly/math/simd_ops.hpp>
+#include <jelly/math/vec_simd.hpp>
+
+namespace jelly {
+
+namespace detail {
+
+inline namespace JELLY_SIMD_NAMESPACE {
+
+
+#if defined(JELLY_SIMD_AVX)
+
+inline void simd_mat4_multiply(const float* a, const float* b, float* o)
+{
+    // Computes two result columns per iteration, with the columns of a
+    // repeated in both 128-bit lanes and the matching b elements broadcast
+    // within each lane
+    __m256 a0 = _mm256_broadcast_ps((const __m128*)(a + 0));
+    __m256 a1 = _mm256_broadcast_ps((const __m128*)(a + 4));
+    __m256 a2 = _mm256_broadcast_ps((const __m128*)(a + 8));
+    __m256 a3 = _mm256_broadcast_ps((const __m128*)(a + 12));
+
+    for (unsigned int col = 0; col < 4; col += 2) {
+        __m256 bb = _mm256_loadu_ps(b + 4*col);
+        __m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(bb, 0x00));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_permute_ps(bb, 0x55)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_permute_ps(bb, 0xAA)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_permute_ps(bb, 0xFF)));
+        _mm256_storeu_ps(o + 4*col, r);
+    }
+}
+
+#elif !defined(JELLY_SIMD_SCALAR)
+
+inline void simd_mat4_multiply(const float* a, const float* b, float* o)
+{
+    using namespace jelly::simd;
+    f32x4 a0 = load(a + 0);
+    f32x4 a1 = load(a + 4);
+    f32x4 a2 = load(a + 8);
+    f32x4 a3 = load(a + 12);
+
+    for (unsigned int col = 0; col < 4; ++col) {
+        const float* bc = b + 4*col;
+        f32x4 r = mul(a0, set1(bc[0]));
+        r = madd(a1, set1(bc[1]), r);
+        r = madd(a2, set1(bc[2]), r);
+        r = madd(a3, set1(bc[3]), r);
+        store(o + 4*col, r);
+    }
+}
+
+#endif
+
+
+#if !defined(JELLY_SIMD_SCALAR)
+
+inline void simd_mat4_transform(const float* m, const float* v, float* o)
+{
+    using namespace jelly::simd;
+    f32x4 r = mul(load(m + 0), set1(v[0]));
+    r = madd(load(m + 4), set1(v[1]), r);
+    r = madd(load(m + 8), set1(v[2]), r);
+    r = madd(load(m + 12), set1(v[3]), r);
+    store(o, r);
+}
+
+
+inline float simd_dot3(jelly::simd::f32x4 a, jelly::simd::f32x4 b)
+{
+    float t[4];
+    jelly::simd::store(t, jelly::simd::mul(a, b));
+    return t[0] + t[1] + t[2];
+}
+
+
+inline void simd_mat4_inverse(const float* m, float* o)
+{
+    // The cross product formulation of detail::inverse, on the upper 3 rows
+    // of the columns
+    using namespace jelly::simd;
+    f32x4 a = load3(m + 0);
+    f32x4 b = load3(m + 4);
+    f32x4 c = load3(m + 8);
+    f32x4 d = load3(m + 12);
+    f32x4 x = set1(m[3]);
+    f32x4 y = set1(m[7]);
+    f32x4 z = set1(m[11]);
+    f32x4 w = set1(m[15]);
+
+    f32x4 s = cross3(a, b);
+    f32x4 t = cross3(c, d);
+    f32x4 u = sub(mul(y, a), mul(x, b));
+    f32x4 v = sub(mul(w, c), mul(z, d));
+
+    f32x4 inv = set1(1.0f / (simd_dot3(s, v) + simd_dot3(t, u)));
+    s = mul(inv, s);
+    t = mul(inv, t);
+    u = mul(inv, u);
+    v = mul(inv, v);
+
+    float rows[4][4];
+    store(rows[0], add(cross3(b, v), mul(y, t)));
+    store(rows[1], sub(cross3(v, a), mul(x, t)));
+    store(rows[2], add(cross3(d, u), mul(w, s)));
+    store(rows[3], sub(cross3(u, c), mul(z, s)));
+    for (unsigned int r = 0; r < 4; ++r) {
+        for (unsigned int i = 0; i < 3; ++i) {
+            o[4*i + r] = rows[r][i];
+        }
+    }
+    o[12] = -simd_dot3(b, t);
+    o[13] = simd_dot3(a, t);
+    o[14] = -simd_dot3(d, s);
+    o[15] = simd_dot3(c, s);
+}
+
+
+inline void simd_mat3_multiply(const float* a, const float* b, float* o)
+{
+    using namespace jelly::simd;
+    f32x4 a0 = load3(a + 0);
+    f32x4 a1 = load3(a + 3);
+    f32x4 a2 = load3(a + 6);
+
+    for (unsigned int col = 0; col < 3; ++col) {
+        const float* bc = b + 3*col;
+        f32x4 r = mul(a0, set1(bc[0]));
+        r = madd(a1, set1(bc[1]), r);
+        r = madd(a2, set1(bc[2]), r);
+        store3(o + 3*col, r);
+    }
+}
+
+
+inline void simd_mat3_transform(const float* m, const float* v, float* o)
+{
+    using namespace jelly::simd;
+    f32x4 r = mul(load3(m + 0), set1(v[0]));
+    r = madd(load3(m + 3), set1(v[1]), r);
+    r = madd(load3(m + 6), set1(v[2]), r);
+    store3(o, r);
+}
+
+
+inline void simd_mat3_transposed_inverse(const float* m, float* o)
+{
+    // The columns of the transposed inverse are the cross products of the
+    // other two columns, divided by the determinant
+    using namespace jelly::simd;
+    f32x4 c0 = load3(m + 0);
+    f32x4 c1 = load3(m + 3);
+    f32x4 c2 = load3(m + 6);
+
+    f32x4 x0 = cross3(c1, c2);
+    f32x4 x1 = cross3(c2, c0);
+    f32x4 x2 = cross3(c0, c1);
+
+    float t[4];
+    store(t, mul(c0, x0));
+    f32x4 inv = set1(1.0f / (t[0] + t[1] + t[2]));
+
+    store3(o + 0, mul(x0, inv));
+    store3(o + 3, mul(x1, inv));
+    store3(o + 6, mul(x2, inv));
+}
+
+#else
+
+inline void simd_mat4_multiply(const float* a, const float* b, float* o)
+{
+    Mat4 result = detail::multiply(Mat4(a), Mat4(b));
+    for (unsigned int i = 0; i < 16; ++i) {
+        o[i] = result[i];
+    }
+}
+
+
+inline void simd_mat4_transform(const float* m, const float* v, float* o)
+{
+    Vec4 result = detail::transform(Mat4(m), Vec4(v[0], v[1], v[2], v[3]));
+    for (unsigned int i = 0; i < 4; ++i) {
+        o[i] = result[i];
+    }
+}
+
+
+inline void simd_mat4_inverse(const float* m, float* o)
+{
+    Mat4 result = detail::inverse(Mat4(m));
+    for (unsigned int i = 0; i < 16; ++i) {
+        o[i] = result[i];
+    }
+}
+
+
+inline void simd_mat3_multiply(const float* a, const float* b, float* o)
+{
+    Mat3 result = detail::multiply(Mat3(a), Mat3(b));
+    for (unsigned int i = 0; i < 9; ++i) {
+        o[i] = result[i];
+    }
+}
+
+
+inline void simd_mat3_transform(const float* m, const float* v, float* o)
+{
+    Vec3 result = detail::transform(Mat3(m), Vec3(v[0], v[1], v[2]));
+    for (unsigned int i = 0; i < 3; ++i) {
+        o[i] = result[i];
+    }
+}
+
+
+inline void simd_mat3_transposed_inverse(const float* m, float* o)
+{
+    Mat3 result = detail::transposed_inverse(Mat3(m));
+    for (unsigned int i = 0; i < 9; ++i) {
+        o[i] = result[i];
+    }
+}
+
+#endif
+
+
+inline void mat3_multiply(const float* a, const float* b, float* o)
+{
+    simd_mat3_multiply(a, b, o);
+
+    if (simd::is_verifying()) {
+        Mat3 reference = detail::multiply(Mat3(a), Mat3(b));
+        simd::_verify("Mat3 * Mat3", o, reference.data(), 9);
+    }
+}
+
+
+inline void mat3_transform(const float* m, const float* v, float* o)
+{
+    simd_mat3_transform(m, v, o);
+
+    if (simd::is_verifying()) {
+        Vec3 reference = detail::transform(Mat3(m), Vec3(v[0], v[1], v[2]));
+        simd::_verify("Mat3 * Vec3", o, reference.data(), 3);
+    }
+}
+
+
+inline void mat3_transposed_inverse(const float* m, float* o)
+{
+    simd_mat3_transposed_inverse(m, o);
+
+    if (simd::is_verifying()) {
+        Mat3 reference = detail::transposed_inverse(Mat3(m));
+        simd::_verify("transposed_inverse(Mat3)", o, reference.data(), 9);
+    }
+}
+
+
+inline void mat4_multiply(const float* a, const float* b, float* o)
+{
+    simd_mat4_multiply(a, b, o);
+
+    if (simd::is_verifying()) {
+        Mat4 reference = detail::multiply(Mat4(a), Mat4(b));
+        simd::_verify("Mat4 * Mat4", o, reference.data(), 16);
+    }
+}
+
+
+inline void mat4_transform(const float* m, const float* v, float* o)
+{
+    simd_mat4_transform(m, v, o);
+
+    if (simd::is_verifying()) {
+        Vec4 reference = detail::transform(Mat4(m), Vec4(v[0], v[1], v[2], v[3]));
+        simd::_verify("Mat4 * Vec4", o, reference.data(), 4);
+    }
+}
+
+
+inline void mat4_inverse(const float* m, float* o)
+{
+    simd_mat4_inverse(m, o);
+
+    if (simd::is_verifying()) {
+        Mat4 reference = detail::inverse(Mat4(m));
+        simd::_verify("inverse(Mat4)", o, reference.data(), 16);
+    }
+}
+
+
+inline void mat4_scale(const float* m, float s, float* o)
+{
+    for (unsigned int col = 0; col < 4; ++col) {
+        vec4_scale(m + 4*col, s, o + 4*col);
+    }
+
+    if (simd::is_verifying()) {
+        float reference[16];
+        for (unsigned int i = 0; i < 16; ++i) {
+            reference[i] = m[i] * s;
+        }
+        simd::_verify("Mat4 * float", o, reference, 16);
+    }
+}
+
+
+}
+
+}
+
+}
+
+#endif
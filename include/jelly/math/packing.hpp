@@ -0,0 +1,107 @@
+#ifndef _JELLY_MATH_PACKING_HPP_
+#define _JELLY_MATH_PACKING_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <jelly/math/vec.hpp>
+
+namespace jelly {
+
+/*
+ * Quantized encodings of vertex attributes, which the GPU decodes when
+ * fetching them, e.g. as GL_HALF_FLOAT or normalized integers. The batch
+ * encoders use the SIMD kernels of the library, and F16C for half floats
+ * when the processor supports it.
+ *
+ * All encoders round to nearest.
+ */
+
+/**
+ * Encodes floats as IEEE half floats. Values too large for a half float
+ * become infinities.
+ */
+void pack_half(const float* in, std::uint16_t* out, std::size_t count);
+
+/**
+ * Decodes an IEEE half float.
+ */
+float unpack_half(std::uint16_t h);
+
+/**
+ * Encodes floats in [0, 1] as 16-bit normalized integers, clamping the values
+ * outside of the range.
+ */
+void pack_unorm16(const float* in, std::uint16_t* out, std::size_t count);
+
+/**
+ * Decodes a 16-bit normalized integer.
+ */
+constexpr float unpack_unorm16(std::uint16_t q)
+{
+    return q / 65535.0f;
+}
+
+/**
+ * Returns the octahedral encoding of a unit vector, which maps the sphere to
+ * [-1, 1]^2 by projecting it onto an octahedron and unfolding the lower half,
+ * see Q. Meyer et al., "On Floating-Point Normal Vectors".
+ */
+inline Vec2 encode_octahedral(const Vec3& n)
+{
+    float inv = 1.0f / (std::fabs(n.x()) + std::fabs(n.y()) + std::fabs(n.z()));
+    float x = n.x() * inv;
+    float y = n.y() * inv;
+    if (n.z() < 0.0f) {
+        float wx = (1.0f - std::fabs(y)) * (x < 0.0f ? -1.0f : 1.0f);
+        float wy = (1.0f - std::fabs(x)) * (y < 0.0f ? -1.0f : 1.0f);
+        x = wx;
+        y = wy;
+    }
+    return Vec2(x, y);
+}
+
+/**
+ * Returns the unit vector of an octahedral encoding, as the GLSL decoder of
+ * VertexCompression does.
+ */
+inline Vec3 decode_octahedral(const Vec2& e)
+{
+    Vec3 v(e.x(), e.y(), 1.0f - std::fabs(e.x()) - std::fabs(e.y()));
+    float t = v.z() < 0.0f ? -v.z() : 0.0f;
+    v.x() += v.x() >= 0.0f ? -t : t;
+    v.y() += v.y() >= 0.0f ? -t : t;
+    return normalize(v);
+}
+
+/**
+ * Encodes unit vectors as octahedral 2D vectors of 16-bit or 8-bit normalized
+ * signed integers, writing 2 components per vector.
+ *
+ * \warning Zero-length vectors result in undefined values.
+ */
+void pack_octahedral(const Vec3* normals, std::int16_t* out, std::size_t count);
+
+void pack_octahedral(const Vec3* normals, std::int8_t* out, std::size_t count);
+
+/**
+ * Decodes an octahedral vector of 2 normalized signed integers.
+ */
+inline Vec3 unpack_octahedral(const std::int16_t* e)
+{
+    float x = e[0] / 32767.0f;
+    float y = e[1] / 32767.0f;
+    return decode_octahedral(Vec2(x < -1.0f ? -1.0f : x, y < -1.0f ? -1.0f : y));
+}
+
+inline Vec3 unpack_octahedral(const std::int8_t* e)
+{
+    float x = e[0] / 127.0f;
+    float y = e[1] / 127.0f;
+    return decode_octahedral(Vec2(x < -1.0f ? -1.0f : x, y < -1.0f ? -1.0f : y));
+}
+
+}
+
+#endif
@@ -0,0 +1,354 @@
+#ifndef _JELLY_MATH_QUAT_HPP_
+#define _JELLY_MATH_QUAT_HPP_
+
+#include <cmath>
+#include <cstddef>
+
+#include <jelly/math/mat.hpp>
+#include <jelly/math/vec.hpp>
+
+namespace jelly {
+
+/**
+ * A quaternion of T representing a rotation, usable in constant expressions.
+ *
+ * The common instantiations are named Quat for float and Quatd for double.
+ * The components are stored as (x, y, z, w) where w is the real part, and
+ * float quaternions are aligned to 16 bytes for SIMD loads.
+ *
+ * As with matrices, q1 * q2 is the rotation q2 followed by q1.
+ */
+template <typename T>
+class alignas(sizeof(T) == 4 ? 16 : alignof(T)) Quaternion {
+
+public:
+
+    typedef T value_type;
+
+    /**
+     * Creates a rotation of a radians around a unit-length axis.
+     */
+    static Quaternion axis_angle(const Vec<3, T>& axis, T a)
+    {
+        return Quaternion(std::sin(a * T(0.5)) * axis, std::cos(a * T(0.5)));
+    }
+
+    /**
+     * Creates an x rotation, see Mat4::x_rotation().
+     */
+    static Quaternion x_rotation(T a)
+    {
+        return Quaternion(std::sin(a * T(0.5)), T(0), T(0), std::cos(a * T(0.5)));
+    }
+
+    /**
+     * Creates a y rotation, see Mat4::y_rotation().
+     */
+    static Quaternion y_rotation(T a)
+    {
+        return Quaternion(T(0), std::sin(a * T(0.5)), T(0), std::cos(a * T(0.5)));
+    }
+
+    /**
+     * Creates a z rotation, see Mat4::z_rotation().
+     */
+    static Quaternion z_rotation(T a)
+    {
+        return Quaternion(T(0), T(0), std::sin(a * T(0.5)), std::cos(a * T(0.5)));
+    }
+
+    /**
+     * Creates the rotation of a rotation matrix.
+     *
+     * \warning The matrix must be orthonormal, i.e. without scaling.
+     */
+    static Quaternion from_matrix(const Mat<3, T>& m)
+    {
+        // Take the square root of the largest of the diagonal sums to keep
+        // the divisions well-conditioned
+        T trace = m(0, 0) + m(1, 1) + m(2, 2);
+        if (trace > T(0)) {
+            T s = T(2) * std::sqrt(trace + T(1));
+            return Quaternion((m(2, 1) - m(1, 2)) / s, (m(0, 2) - m(2, 0)) / s,
+                              (m(1, 0) - m(0, 1)) / s, T(0.25) * s);
+        } else if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2)) {
+            T s = T(2) * std::sqrt(T(1) + m(0, 0) - m(1, 1) - m(2, 2));
+            return Quaternion(T(0.25) * s, (m(0, 1) + m(1, 0)) / s,
+                              (m(0, 2) + m(2, 0)) / s, (m(2, 1) - m(1, 2)) / s);
+        } else if (m(1, 1) > m(2, 2)) {
+            T s = T(2) * std::sqrt(T(1) + m(1, 1) - m(0, 0) - m(2, 2));
+            return Quaternion((m(0, 1) + m(1, 0)) / s, T(0.25) * s,
+                              (m(1, 2) + m(2, 1)) / s, (m(0, 2) - m(2, 0)) / s);
+        } else {
+            T s = T(2) * std::sqrt(T(1) + m(2, 2) - m(0, 0) - m(1, 1));
+            return Quaternion((m(0, 2) + m(2, 0)) / s, (m(1, 2) + m(2, 1)) / s,
+                              T(0.25) * s, (m(1, 0) - m(0, 1)) / s);
+        }
+    }
+
+    /**
+     * Creates the rotation of the top-left part of a transformation matrix.
+     *
+     * \warning The matrix must not contain scaling.
+     */
+    static Quaternion from_matrix(const Mat<4, T>& m)
+    {
+        return from_matrix(topleft(m));
+    }
+
+    /**
+     * Creates an identity rotation.
+     */
+    constexpr Quaternion() : _data{T(0), T(0), T(0), T(1)} {}
+
+    constexpr Quaternion(T x, T y, T z, T w) : _data{x, y, z, w} {}
+
+    /**
+     * Creates a quaternion from its vector and real parts.
+     */
+    constexpr Quaternion(const Vec<3, T>& xyz, T w) : _data{xyz.x(), xyz.y(), xyz.z(), w} {}
+
+    constexpr T* data() { return _data; }
+    constexpr const T* data() const { return _data; }
+
+    constexpr T& operator[](std::size_t i) { return _data[i]; }
+    constexpr T operator[](std::size_t i) const { return _data[i]; }
+
+    constexpr T& x() { return _data[0]; }
+    constexpr T x() const { return _data[0]; }
+    constexpr T& y() { return _data[1]; }
+    constexpr T y() const { return _data[1]; }
+    constexpr T& z() { return _data[2]; }
+    constexpr T z() const { return _data[2]; }
+    constexpr T& w() { return _data[3]; }
+    constexpr T w() const { return _data[3]; }
+
+    /**
+     * Returns the vector part.
+     */
+    constexpr Vec<3, T> xyz() const { return Vec<3, T>(x(), y(), z()); }
+
+private:
+
+    T _data[4];
+
+};
+
+typedef Quaternion<float> Quat;
+typedef Quaternion<double> Quatd;
+
+
+/**
+ * Quaternion composition, the rotation b followed by a.
+ */
+template <typename T>
+constexpr Quaternion<T> operator*(const Quaternion<T>& a, const Quaternion<T>& b)
+{
+    return Quaternion<T>(
+        a.w()*b.x() + a.x()*b.w() + a.y()*b.z() - a.z()*b.y(),
+        a.w()*b.y() - a.x()*b.z() + a.y()*b.w() + a.z()*b.x(),
+        a.w()*b.z() + a.x()*b.y() - a.y()*b.x() + a.z()*b.w(),
+        a.w()*b.w() - a.x()*b.x() - a.y()*b.y() - a.z()*b.z()
+    );
+}
+
+/**
+ * Rotates a vector by a unit quaternion.
+ */
+template <typename T>
+constexpr Vec<3, T> operator*(const Quaternion<T>& q, const Vec<3, T>& v)
+{
+    Vec<3, T> u = q.xyz();
+    Vec<3, T> t = T(2) * cross(u, v);
+    return v + q.w() * t + cross(u, t);
+}
+
+template <typename T>
+constexpr Quaternion<T> operator+(const Quaternion<T>& a, const Quaternion<T>& b)
+{
+    return Quaternion<T>(a.x() + b.x(), a.y() + b.y(), a.z() + b.z(), a.w() + b.w());
+}
+
+template <typename T>
+constexpr Quaternion<T> operator-(const Quaternion<T>& a, const Quaternion<T>& b)
+{
+    return Quaternion<T>(a.x() - b.x(), a.y() - b.y(), a.z() - b.z(), a.w() - b.w());
+}
+
+/**
+ * Quaternion negation, which represents the same rotation.
+ */
+template <typename T>
+constexpr Quaternion<T> operator-(const Quaternion<T>& q)
+{
+    return Quaternion<T>(-q.x(), -q.y(), -q.z(), -q.w());
+}
+
+/**
+ * Scalar-quaternion multiplication.
+ */
+template <typename T>
+constexpr Quaternion<T> operator*(typename Quaternion<T>::value_type s, const Quaternion<T>& q)
+{
+    return Quaternion<T>(s * q.x(), s * q.y(), s * q.z(), s * q.w());
+}
+
+/**
+ * Quaternion-scalar multiplication.
+ */
+template <typename T>
+constexpr Quaternion<T> operator*(const Quaternion<T>& q, typename Quaternion<T>::value_type s)
+{
+    return Quaternion<T>(q.x() * s, q.y() * s, q.z() * s, q.w() * s);
+}
+
+template <typename T>
+constexpr bool operator==(const Quaternion<T>& a, const Quaternion<T>& b)
+{
+    return a.x() == b.x() && a.y() == b.y() && a.z() == b.z() && a.w() == b.w();
+}
+
+template <typename T>
+constexpr bool operator!=(const Quaternion<T>& a, const Quaternion<T>& b)
+{
+    return !(a == b);
+}
+
+/**
+ * Dot product of the 4 components, the cosine of half the angle between two
+ * unit quaternions.
+ */
+template <typename T>
+constexpr T dot(const Quaternion<T>& a, const Quaternion<T>& b)
+{
+    return a.x()*b.x() + a.y()*b.y() + a.z()*b.z() + a.w()*b.w();
+}
+
+/**
+ * Returns the conjugate, which is the inverse rotation of a unit quaternion.
+ */
+template <typename T>
+constexpr Quaternion<T> conjugate(const Quaternion<T>& q)
+{
+    return Quaternion<T>(-q.x(), -q.y(), -q.z(), q.w());
+}
+
+template <typename T>
+inline T magnitude(const Quaternion<T>& q)
+{
+    return std::sqrt(dot(q, q));
+}
+
+/**
+ * Normalized quaternion, q/||q||. Products of unit quaternions slowly drift
+ * from unit length and should be normalized now and then.
+ *
+ * \warning The magnitude is not checked to be non-zero.
+ */
+template <typename T>
+inline Quaternion<T> normalize(const Quaternion<T>& q)
+{
+    return (T(1) / magnitude(q)) * q;
+}
+
+/**
+ * Returns the rotation matrix of a unit quaternion.
+ */
+template <typename T>
+constexpr Mat<3, T> to_mat3(const Quaternion<T>& q)
+{
+    T x2 = q.x() + q.x();
+    T y2 = q.y() + q.y();
+    T z2 = q.z() + q.z();
+    Mat<3, T> m;
+    m(0, 0) = T(1) - q.y()*y2 - q.z()*z2;
+    m(0, 1) = q.x()*y2 - q.w()*z2;
+    m(0, 2) = q.x()*z2 + q.w()*y2;
+    m(1, 0) = q.x()*y2 + q.w()*z2;
+    m(1, 1) = T(1) - q.x()*x2 - q.z()*z2;
+    m(1, 2) = q.y()*z2 - q.w()*x2;
+    m(2, 0) = q.x()*z2 - q.w()*y2;
+    m(2, 1) = q.y()*z2 + q.w()*x2;
+    m(2, 2) = T(1) - q.x()*x2 - q.y()*y2;
+    return m;
+}
+
+/**
+ * Returns the rotation of a unit quaternion as a 4x4 transformation matrix.
+ */
+template <typename T>
+constexpr Mat<4, T> to_mat4(const Quaternion<T>& q)
+{
+    return Mat<4, T>(to_mat3(q));
+}
+
+/**
+ * Normalized linear interpolation from a to b along the shortest path.
+ *
+ * Cheaper than slerp() but the angular velocity is not constant, which is
+ * rarely visible between close keyframes.
+ */
+template <typename T>
+inline Quaternion<T> nlerp(const Quaternion<T>& a, const Quaternion<T>& b, T t)
+{
+    T tb = dot(a, b) < T(0) ? -t : t;
+    return normalize((T(1) - t) * a + tb * b);
+}
+
+/**
+ * Spherical linear interpolation from a to b along the shortest path.
+ *
+ * The ratios of sines are evaluated with a polynomial instead of
+ * trigonometric functions, accurate to about 1e-7 for unit quaternions and
+ * t in [0, 1], so that it vectorizes. See D. Eberly, "A Fast and Accurate
+ * Algorithm for Computing SLERP".
+ */
+template <typename T>
+constexpr Quaternion<T> slerp(const Quaternion<T>& a, const Quaternion<T>& b, T t)
+{
+    T cs = dot(a, b);
+    T sign = T(1);
+    if (cs < T(0)) {
+        cs = -cs;
+        sign = T(-1);
+    }
+
+    // sin(t*angle)/sin(angle) is t times a series in cos(angle) - 1 with
+    // coefficients u*t^2 - v, truncated after 16 terms and corrected by mu
+    const T mu = T(1.917);
+    T xm1 = cs - T(1);
+    T s = T(1) - t;
+    T t2 = t * t;
+    T s2 = s * s;
+    T ft = T(1);
+    T fs = T(1);
+    for (int i = 15; i >= 0; --i) {
+        T u = T(1) / T((i + 1) * (2*i + 3));
+        T v = T(i + 1) / T(2*i + 3);
+        if (i == 15) {
+            u *= mu;
+            v *= mu;
+        }
+        ft = T(1) + (u * t2 - v) * xm1 * ft;
+        fs = T(1) + (u * s2 - v) * xm1 * fs;
+    }
+    return (s * fs) * a + (sign * t * ft) * b;
+}
+
+/*
+ * Batch interpolation of arrays of float quaternions, using the SIMD kernels
+ * of the library. Each out[i] interpolates from a[i] to b[i], either by the
+ * same t or by t[i]. The output may be the same as an input.
+ */
+
+void nlerp(const Quat* a, const Quat* b, float t, Quat* out, std::size_t count);
+
+void nlerp(const Quat* a, const Quat* b, const float* t, Quat* out, std::size_t count);
+
+void slerp(const Quat* a, const Quat* b, float t, Quat* out, std::size_t count);
+
+void slerp(const Quat* a, const Quat* b, const float* t, Quat* out, std::size_t count);
+
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _JELLY_MATH_SIMD_HPP_
+#define _JELLY_MATH_SIMD_HPP_
+
+namespace jelly {
+
+/**
+ * Controls the SIMD kernels used by the math types.
+ *
+ * The backend is chosen at compile time, from the JELLY_SIMD CMake option
+ * or the instruction sets enabled for the compiler: AVX, SSE2, NEON, or a
+ * scalar fallback. The kernels are inline in the math headers, so each source
+ * runs the backend of its own flags, which the CMake option exports to the
+ * targets linking jelly.
+ */
+namespace simd {
+
+/**
+ * Returns the name of the SIMD backend of the jelly sources, i.e. "AVX",
+ * "SSE2", "NEON" or "scalar". Code built with other flags than jelly may run
+ * another backend in the inline kernels.
+ */
+const char* backend();
+
+/**
+ * Enables or disables verification. While enabled, every SIMD kernel also
+ * runs its scalar counterpart and prints a warning when the results differ by
+ * more than rounding errors. Disabled by default.
+ */
+void set_verify(bool enabled);
+
+/**
+ * Whether verification is enabled, read by the inline kernels.
+ */
+extern bool _verifying;
+
+/**
+ * Returns true if verification is enabled.
+ */
+inline bool is_verifying() { return _verifying; }
+
+/**
+ * Returns the number of mismatches found since verification was enabled.
+ */
+unsigned int get_mismatch_count();
+
+}
+
+}
+
+#endif
@@ -0,0 +1,377 @@
+#ifndef _JELLY_MATH_SIMD_OPS_HPP_
+#define _JELLY_MATH_SIMD_OPS_HPP_
+
+#include <cmath>
+#include <cstdint>
+
+#include <jelly/math/simd.hpp>
+
+// Select the backend from the enabled instruction sets, unless the build
+// forces the scalar fallback
+#if defined(JELLY_SIMD_SCALAR)
+#elif defined(__AVX__)
+#define JELLY_SIMD_AVX
+#define JELLY_SIMD_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JELLY_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define JELLY_SIMD_NEON
+#else
+#define JELLY_SIMD_SCALAR
+#endif
+
+// The namespace of the inline kernels, named after the backend so that
+// sources built for different instruction sets never share a definition
+#if defined(JELLY_SIMD_AVX)
+#define JELLY_SIMD_NAMESPACE avx
+#elif defined(JELLY_SIMD_SSE2)
+#define JELLY_SIMD_NAMESPACE sse2
+#elif defined(JELLY_SIMD_NEON)
+#define JELLY_SIMD_NAMESPACE neon
+#else
+#define JELLY_SIMD_NAMESPACE scalar
+#endif
+
+// The float Vec4, Mat3 and Mat4 operators use the inline SIMD kernels at run
+// time, which requires telling constant evaluation apart
+#if !defined(JELLY_SIMD_SCALAR)
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define JELLY_MATH_SIMD_DISPATCH
+#endif
+#endif
+#if !defined(JELLY_MATH_SIMD_DISPATCH) && defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 9
+#define JELLY_MATH_SIMD_DISPATCH
+#endif
+#if !defined(JELLY_MATH_SIMD_DISPATCH) && defined(_MSC_VER) && _MSC_VER >= 1925
+#define JELLY_MATH_SIMD_DISPATCH
+#endif
+#endif
+
+#if defined(JELLY_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(JELLY_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(JELLY_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace jelly {
+
+namespace simd {
+
+/**
+ * Compares the result of a SIMD kernel to its scalar reference, counting and
+ * reporting a mismatch.
+ */
+void _verify(const char* kernel, const float* result, const float* reference, unsigned int n);
+
+#if !defined(JELLY_SIMD_SCALAR)
+
+/*
+ * A minimal abstraction of 4-wide float vectors shared by the SSE2 and NEON
+ * kernels. Functions ending in _aligned require 16-byte aligned pointers.
+ */
+
+#if defined(JELLY_SIMD_SSE2)
+
+typedef __m128 f32x4;
+
+inline f32x4 load(const float* p) { return _mm_loadu_ps(p); }
+inline f32x4 load_aligned(const float* p) { return _mm_load_ps(p); }
+inline void store(float* p, f32x4 v) { _mm_storeu_ps(p, v); }
+inline void store_aligned(float* p, f32x4 v) { _mm_store_ps(p, v); }
+inline f32x4 set1(float f) { return _mm_set1_ps(f); }
+inline f32x4 add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+inline f32x4 sub(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+inline f32x4 mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+inline f32x4 div(f32x4 a, f32x4 b) { return _mm_div_ps(a, b); }
+inline f32x4 min(f32x4 a, f32x4 b) { return _mm_min_ps(a, b); }
+inline f32x4 max(f32x4 a, f32x4 b) { return _mm_max_ps(a, b); }
+inline f32x4 abs(f32x4 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+
+/**
+ * Splits the lanes of (a, b) into the even and odd lanes.
+ */
+inline void deinterleave(f32x4 a, f32x4 b, f32x4& even, f32x4& odd)
+{
+    even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+/**
+ * Returns 1/sqrt(v), accurate to rounding.
+ */
+inline f32x4 rsqrt(f32x4 v) { return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(v)); }
+
+/**
+ * Returns the lanes of a where w is positive and those of b elsewhere.
+ */
+inline f32x4 select_positive(f32x4 w, f32x4 a, f32x4 b)
+{
+    __m128 mask = _mm_cmpgt_ps(w, _mm_setzero_ps());
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/**
+ * Loads 4 consecutive 3D vectors, deinterleaving the components.
+ */
+inline void load3x4(const float* p, f32x4& x, f32x4& y, f32x4& z)
+{
+    // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+    __m128 a = _mm_loadu_ps(p);
+    __m128 b = _mm_loadu_ps(p + 4);
+    __m128 c = _mm_loadu_ps(p + 8);
+    __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+    x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                       _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                       _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/**
+ * Stores 4 consecutive 3D vectors, interleaving the components.
+ */
+inline void store3x4(float* p, f32x4 x, f32x4 y, f32x4 z)
+{
+    __m128 a = _mm_shuffle_ps(_mm_unpacklo_ps(x, y),
+                              _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0));
+    __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+                              _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+                              _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    _mm_storeu_ps(p, a);
+    _mm_storeu_ps(p + 4, b);
+    _mm_storeu_ps(p + 8, c);
+}
+
+/**
+ * Loads 4 consecutive 4D vectors, deinterleaving the components.
+ */
+inline void load4x4(const float* p, f32x4& x, f32x4& y, f32x4& z, f32x4& w)
+{
+    x = _mm_loadu_ps(p);
+    y = _mm_loadu_ps(p + 4);
+    z = _mm_loadu_ps(p + 8);
+    w = _mm_loadu_ps(p + 12);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+/**
+ * Stores 4 consecutive 4D vectors, interleaving the components.
+ */
+inline void store4x4(float* p, f32x4 x, f32x4 y, f32x4 z, f32x4 w)
+{
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(p, x);
+    _mm_storeu_ps(p + 4, y);
+    _mm_storeu_ps(p + 8, z);
+    _mm_storeu_ps(p + 12, w);
+}
+
+/**
+ * Returns (y, z, x, w).
+ */
+inline f32x4 yzx(f32x4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1)); }
+
+/**
+ * Stores the lanes rounded to the nearest integers, ties to even.
+ */
+inline void store_rounded(std::int32_t* p, f32x4 v) { _mm_storeu_si128((__m128i*)p, _mm_cvtps_epi32(v)); }
+
+/**
+ * Returns the sum of all lanes.
+ */
+inline float sum(f32x4 v)
+{
+    f32x4 t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    t = _mm_add_ss(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(t);
+}
+
+#elif defined(JELLY_SIMD_NEON)
+
+typedef float32x4_t f32x4;
+
+inline f32x4 load(const float* p) { return vld1q_f32(p); }
+inline f32x4 load_aligned(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, f32x4 v) { vst1q_f32(p, v); }
+inline void store_aligned(float* p, f32x4 v) { vst1q_f32(p, v); }
+inline f32x4 set1(float f) { return vdupq_n_f32(f); }
+inline f32x4 add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+inline f32x4 sub(f32x4 a, f32x4 b) { return vsubq_f32(a, b); }
+inline f32x4 mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+inline f32x4 min(f32x4 a, f32x4 b) { return vminq_f32(a, b); }
+inline f32x4 max(f32x4 a, f32x4 b) { return vmaxq_f32(a, b); }
+inline f32x4 abs(f32x4 v) { return vabsq_f32(v); }
+
+/**
+ * Splits the lanes of (a, b) into the even and odd lanes.
+ */
+inline void deinterleave(f32x4 a, f32x4 b, f32x4& even, f32x4& odd)
+{
+    float32x4x2_t v = vuzpq_f32(a, b);
+    even = v.val[0];
+    odd = v.val[1];
+}
+
+#if defined(__aarch64__)
+
+inline f32x4 div(f32x4 a, f32x4 b) { return vdivq_f32(a, b); }
+inline f32x4 rsqrt(f32x4 v) { return vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(v)); }
+
+#else
+
+// ARMv7 has no division or square root, refine the estimates instead
+
+inline f32x4 div(f32x4 a, f32x4 b)
+{
+    float32x4_t r = vrecpeq_f32(b);
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    return vmulq_f32(a, r);
+}
+
+inline f32x4 rsqrt(f32x4 v)
+{
+    float32x4_t r = vrsqrteq_f32(v);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(v, r), r));
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(v, r), r));
+    return r;
+}
+
+#endif
+
+/**
+ * Returns the lanes of a where w is positive and those of b elsewhere.
+ */
+inline f32x4 select_positive(f32x4 w, f32x4 a, f32x4 b)
+{
+    return vbslq_f32(vcgtq_f32(w, vdupq_n_f32(0.0f)), a, b);
+}
+
+/**
+ * Loads 4 consecutive 3D vectors, deinterleaving the components.
+ */
+inline void load3x4(const float* p, f32x4& x, f32x4& y, f32x4& z)
+{
+    float32x4x3_t v = vld3q_f32(p);
+    x = v.val[0];
+    y = v.val[1];
+    z = v.val[2];
+}
+
+/**
+ * Stores 4 consecutive 3D vectors, interleaving the components.
+ */
+inline void store3x4(float* p, f32x4 x, f32x4 y, f32x4 z)
+{
+    float32x4x3_t v;
+    v.val[0] = x;
+    v.val[1] = y;
+    v.val[2] = z;
+    vst3q_f32(p, v);
+}
+
+/**
+ * Loads 4 consecutive 4D vectors, deinterleaving the components.
+ */
+inline void load4x4(const float* p, f32x4& x, f32x4& y, f32x4& z, f32x4& w)
+{
+    float32x4x4_t v = vld4q_f32(p);
+    x = v.val[0];
+    y = v.val[1];
+    z = v.val[2];
+    w = v.val[3];
+}
+
+/**
+ * Stores 4 consecutive 4D vectors, interleaving the components.
+ */
+inline void store4x4(float* p, f32x4 x, f32x4 y, f32x4 z, f32x4 w)
+{
+    float32x4x4_t v;
+    v.val[0] = x;
+    v.val[1] = y;
+    v.val[2] = z;
+    v.val[3] = w;
+    vst4q_f32(p, v);
+}
+
+/**
+ * Returns (y, z, x, ?). The last lane is unspecified.
+ */
+inline f32x4 yzx(f32x4 v) { return vsetq_lane_f32(vgetq_lane_f32(v, 0), vextq_f32(v, v, 1), 2); }
+
+/**
+ * Stores the lanes rounded to the nearest integers, ties to even.
+ */
+#if defined(__aarch64__)
+inline void store_rounded(std::int32_t* p, f32x4 v) { vst1q_s32(p, vcvtnq_s32_f32(v)); }
+#else
+inline void store_rounded(std::int32_t* p, f32x4 v)
+{
+    // ARMv7 NEON only converts towards zero
+    float t[4];
+    vst1q_f32(t, v);
+    for (unsigned int i = 0; i < 4; ++i) {
+        p[i] = (std::int32_t)std::lrint(t[i]);
+    }
+}
+#endif
+
+/**
+ * Returns the sum of all lanes.
+ */
+inline float sum(f32x4 v)
+{
+    float32x2_t t = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(t, t), 0);
+}
+
+#endif
+
+/**
+ * Returns a * b + c.
+ */
+inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) { return add(mul(a, b), c); }
+
+/**
+ * Loads 3 floats, setting the last lane to zero.
+ */
+inline f32x4 load3(const float* p)
+{
+    float t[4] = {p[0], p[1], p[2], 0.0f};
+    return load(t);
+}
+
+/**
+ * Stores the first 3 lanes.
+ */
+inline void store3(float* p, f32x4 v)
+{
+    float t[4];
+    store(t, v);
+    p[0] = t[0];
+    p[1] = t[1];
+    p[2] = t[2];
+}
+
+/**
+ * Returns the cross product of the first 3 lanes. The last lane is
+ * unspecified.
+ */
+inline f32x4 cross3(f32x4 a, f32x4 b)
+{
+    f32x4 c = sub(mul(a, yzx(b)), mul(yzx(a), b));
+    return yzx(c);
+}
+
+#endif
+
+}
+
+}
+
+#endif
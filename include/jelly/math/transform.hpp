@@ -0,0 +1,91 @@
+#ifndef _JELLY_MATH_TRANSFORM_HPP_
+#define _JELLY_MATH_TRANSFORM_HPP_
+
+#include <cstddef>
+
+#include <jelly/math/mat.hpp>
+#include <jelly/math/vec.hpp>
+
+namespace jelly {
+
+/*
+ * Batch transforms of contiguous arrays, using the SIMD kernels of the library
+ * and split across threads for large inputs.
+ *
+ * Each function takes either an array of vectors or structure-of-arrays
+ * buffers with one array per component. The output may be the same as the
+ * input, but must not partially overlap it.
+ */
+
+/**
+ * Transforms points by m, i.e. m * (p, 1) without the w component. The matrix
+ * is assumed to be affine, use project_points() for projections.
+ */
+void transform_points(const Mat4& m, const Vec3* points, Vec3* out, std::size_t count);
+
+void transform_points(const Mat4& m, const float* x, const float* y, const float* z,
+                      float* out_x, float* out_y, float* out_z, std::size_t count);
+
+/**
+ * Transforms homogeneous points by m.
+ */
+void transform_points(const Mat4& m, const Vec4* points, Vec4* out, std::size_t count);
+
+/**
+ * Transforms directions by m, i.e. m * (d, 0) without the w component.
+ * Translations do not apply and the results are not normalized.
+ */
+void transform_directions(const Mat4& m, const Vec3* directions, Vec3* out, std::size_t count);
+
+void transform_directions(const Mat4& m, const float* x, const float* y, const float* z,
+                          float* out_x, float* out_y, float* out_z, std::size_t count);
+
+/**
+ * Transforms normals by the normal matrix of the model matrix m, see
+ * normal_matrix(), and normalizes the results.
+ *
+ * \warning Zero-length normals result in NaNs.
+ */
+void transform_normals(const Mat4& m, const Vec3* normals, Vec3* out, std::size_t count);
+
+void transform_normals(const Mat4& m, const float* x, const float* y, const float* z,
+                       float* out_x, float* out_y, float* out_z, std::size_t count);
+
+/**
+ * Projects points to window coordinates, as the GPU would for the vertices of
+ * a draw.
+ *
+ * Each result holds the window x and y, with the origin at the bottom left as
+ * for glViewport, and the depth in [0, 1]. Points on or behind the eye plane
+ * (clip w <= 0) have no projection and are set to NaN.
+ *
+ * \param m
+ *     The model-view-projection matrix.
+ * \param viewport
+ *     The viewport as (x, y, width, height).
+ */
+void project_points(const Mat4& m, const Vec4& viewport, const Vec3* points, Vec3* out,
+                    std::size_t count);
+
+void project_points(const Mat4& m, const Vec4& viewport, const float* x, const float* y,
+                    const float* z, float* out_x, float* out_y, float* out_z, std::size_t count);
+
+/**
+ * Sets the maximum number of threads used by a batch transform, including the
+ * calling thread. Inputs are only split when each thread gets a large enough
+ * part to outweigh starting it. Defaults to the number of hardware threads.
+ *
+ * \param count
+ *     The thread count, 1 to always transform on the calling thread or 0 for
+ *     the default.
+ */
+void set_transform_threads(unsigned int count);
+
+/**
+ * Returns the maximum number of threads used by a batch transform.
+ */
+unsigned int get_transform_threads();
+
+}
+
+#endif
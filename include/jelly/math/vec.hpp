@@ -0,0 +1,327 @@
+#ifndef _JELLY_MATH_VEC_HPP_
+#define _JELLY_MATH_VEC_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include <jelly/math/simd_ops.hpp>
+
+namespace jelly {
+
+namespace detail {
+
+/*
+ * The Vec4 SIMD kernels, defined inline in jelly/math/vec_simd.hpp so that
+ * they inline into user code.
+ */
+inline namespace JELLY_SIMD_NAMESPACE {
+inline void vec4_add(const float* a, const float* b, float* o);
+inline void vec4_sub(const float* a, const float* b, float* o);
+inline void vec4_scale(const float* v, float s, float* o);
+inline float vec4_dot(const float* a, const float* b);
+}
+
+}
+
+/**
+ * An N-dimensional vector of T, usable in constant expressions.
+ *
+ * The common instantiations are named Vec2, Vec3 and Vec4 for float, with d
+ * and i suffixes for double and int, e.g. Vec3d. 4D float vectors are aligned
+ * to 16 bytes for SIMD loads.
+ */
+template <std::size_t N, typename T>
+class alignas((N == 4 && sizeof(T) == 4) ? 16 : alignof(T)) Vec {
+
+    static_assert(N >= 2, "Vectors need at least 2 components");
+
+public:
+
+    /**
+     * Creates a zero vector.
+     */
+    constexpr Vec() : _data{} {}
+
+    /**
+     * Creates a vector with all components set to v.
+     */
+    constexpr Vec(T v) : _data{}
+    {
+        for (std::size_t i = 0; i < N; ++i) _data[i] = v;
+    }
+
+    template <std::size_t M = N, typename = typename std::enable_if<M == 2>::type>
+    constexpr Vec(T x, T y) : _data{x, y} {}
+
+    template <std::size_t M = N, typename = typename std::enable_if<M == 3>::type>
+    constexpr Vec(T x, T y, T z) : _data{x, y, z} {}
+
+    template <std::size_t M = N, typename = typename std::enable_if<M == 3>::type>
+    constexpr Vec(const Vec<2, T>& xy, T z) : _data{xy.x(), xy.y(), z} {}
+
+    template <std::size_t M = N, typename = typename std::enable_if<M == 3>::type>
+    constexpr Vec(T x, const Vec<2, T>& yz) : _data{x, yz.x(), yz.y()} {}
+
+    template <std::size_t M = N, typename = typename std::enable_if<M == 4>::type>
+    constexpr Vec(T x, T y, T z, T w) : _data{x, y, z, w} {}
+
+    template <std::size_t M = N, typename = typename std::enable_if<M == 4>::type>
+    constexpr Vec(const Vec<3, T>& xyz, T w) : _data{xyz.x(), xyz.y(), xyz.z(), w} {}
+
+    constexpr T* data() { return _data; }
+    constexpr const T* data() const { return _data; }
+
+    constexpr T& operator[](std::size_t i) { return _data[i]; }
+    constexpr T operator[](std::size_t i) const { return _data[i]; }
+
+    constexpr T& x() { return _data[0]; }
+    constexpr T x() const { return _data[0]; }
+    constexpr T& y() { return _data[1]; }
+    constexpr T y() const { return _data[1]; }
+
+    constexpr T& z()
+    {
+        static_assert(N >= 3, "Vector has no z component");
+        return _data[2];
+    }
+
+    constexpr T z() const
+    {
+        static_assert(N >= 3, "Vector has no z component");
+        return _data[2];
+    }
+
+    constexpr T& w()
+    {
+        static_assert(N >= 4, "Vector has no w component");
+        return _data[3];
+    }
+
+    constexpr T w() const
+    {
+        static_assert(N >= 4, "Vector has no w component");
+        return _data[3];
+    }
+
+    constexpr Vec<2, T> xy() const { return Vec<2, T>(x(), y()); }
+    constexpr Vec<2, T> yx() const { return Vec<2, T>(y(), x()); }
+    constexpr Vec<2, T> xz() const { return Vec<2, T>(x(), z()); }
+    constexpr Vec<2, T> yz() const { return Vec<2, T>(y(), z()); }
+    constexpr Vec<2, T> zx() const { return Vec<2, T>(z(), x()); }
+    constexpr Vec<2, T> zy() const { return Vec<2, T>(z(), y()); }
+
+    constexpr Vec<3, T> xyz() const { return Vec<3, T>(x(), y(), z()); }
+    constexpr Vec<3, T> xzy() const { return Vec<3, T>(x(), z(), y()); }
+    constexpr Vec<3, T> yxz() const { return Vec<3, T>(y(), x(), z()); }
+    constexpr Vec<3, T> yzx() const { return Vec<3, T>(y(), z(), x()); }
+    constexpr Vec<3, T> zxy() const { return Vec<3, T>(z(), x(), y()); }
+    constexpr Vec<3, T> zyx() const { return Vec<3, T>(z(), y(), x()); }
+
+    // The operators are defined as friends so that scalars convert to vectors
+    // implicitly, as with the non-template vector classes
+
+    /**
+     * Vector-vector addition.
+     */
+    friend constexpr Vec operator+(const Vec& a, const Vec& b)
+    {
+        return _add(a, b, _Simd());
+    }
+
+    /**
+     * Vector-vector subtraction.
+     */
+    friend constexpr Vec operator-(const Vec& a, const Vec& b)
+    {
+        return _sub(a, b, _Simd());
+    }
+
+    /**
+     * Vector negation, equivalent to -1 * v.
+     */
+    friend constexpr Vec operator-(const Vec& v)
+    {
+        return _scale(v, T(-1), _Simd());
+    }
+
+    /**
+     * Scalar-vector multiplication.
+     */
+    friend constexpr Vec operator*(T s, const Vec& v)
+    {
+        return _scale(v, s, _Simd());
+    }
+
+    /**
+     * Vector-scalar multiplication.
+     */
+    friend constexpr Vec operator*(const Vec& v, T s)
+    {
+        return _scale(v, s, _Simd());
+    }
+
+    /**
+     * Component-wise equality.
+     */
+    friend constexpr bool operator==(const Vec& a, const Vec& b)
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (a[i] != b[i]) return false;
+        }
+        return true;
+    }
+
+    friend constexpr bool operator!=(const Vec& a, const Vec& b)
+    {
+        return !(a == b);
+    }
+
+private:
+
+    // Whether the operators have SIMD kernels, which only the float Vec4
+    // overloads below instantiate
+    typedef std::integral_constant<bool, N == 4 && std::is_same<T, float>::value> _Simd;
+
+    static constexpr Vec _add(const Vec& a, const Vec& b, std::false_type)
+    {
+        Vec result;
+        for (std::size_t i = 0; i < N; ++i) result[i] = a[i] + b[i];
+        return result;
+    }
+
+    static constexpr Vec _sub(const Vec& a, const Vec& b, std::false_type)
+    {
+        Vec result;
+        for (std::size_t i = 0; i < N; ++i) result[i] = a[i] - b[i];
+        return result;
+    }
+
+    static constexpr Vec _scale(const Vec& v, T s, std::false_type)
+    {
+        Vec result;
+        for (std::size_t i = 0; i < N; ++i) result[i] = v[i] * s;
+        return result;
+    }
+
+    static constexpr Vec _add(const Vec& a, const Vec& b, std::true_type)
+    {
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+        if (!__builtin_is_constant_evaluated()) {
+            Vec result;
+            detail::vec4_add(a.data(), b.data(), result.data());
+            return result;
+        }
+#endif
+        return _add(a, b, std::false_type());
+    }
+
+    static constexpr Vec _sub(const Vec& a, const Vec& b, std::true_type)
+    {
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+        if (!__builtin_is_constant_evaluated()) {
+            Vec result;
+            detail::vec4_sub(a.data(), b.data(), result.data());
+            return result;
+        }
+#endif
+        return _sub(a, b, std::false_type());
+    }
+
+    static constexpr Vec _scale(const Vec& v, T s, std::true_type)
+    {
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+        if (!__builtin_is_constant_evaluated()) {
+            Vec result;
+            detail::vec4_scale(v.data(), s, result.data());
+            return result;
+        }
+#endif
+        return _scale(v, s, std::false_type());
+    }
+
+    T _data[N];
+
+};
+
+typedef Vec<2, float> Vec2;
+typedef Vec<3, float> Vec3;
+typedef Vec<4, float> Vec4;
+
+typedef Vec<2, double> Vec2d;
+typedef Vec<3, double> Vec3d;
+typedef Vec<4, double> Vec4d;
+
+typedef Vec<2, int> Vec2i;
+typedef Vec<3, int> Vec3i;
+typedef Vec<4, int> Vec4i;
+
+
+/**
+ * Dot product, a dot b.
+ */
+template <std::size_t N, typename T>
+constexpr T dot(const Vec<N, T>& a, const Vec<N, T>& b)
+{
+    T result = a[0] * b[0];
+    for (std::size_t i = 1; i < N; ++i) result += a[i] * b[i];
+    return result;
+}
+
+constexpr float dot(const Vec4& a, const Vec4& b)
+{
+#if defined(JELLY_MATH_SIMD_DISPATCH)
+    if (!__builtin_is_constant_evaluated()) {
+        return detail::vec4_dot(a.data(), b.data());
+    }
+#endif
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+}
+
+/**
+ * Vector magnitude, ||v||.
+ */
+template <std::size_t N, typename T>
+inline T magnitude(const Vec<N, T>& v)
+{
+    return std::sqrt(dot(v, v));
+}
+
+/**
+ * Vector distance, ||b - a||.
+ */
+template <std::size_t N, typename T>
+inline T distance(const Vec<N, T>& a, const Vec<N, T>& b)
+{
+    return magnitude(b - a);
+}
+
+/**
+ * Normalized vector, v/||v||.
+ *
+ * \warning The magnitude is not checked to be non-zero.
+ */
+template <std::size_t N, typename T>
+inline Vec<N, T> normalize(const Vec<N, T>& v)
+{
+    return (T(1) / magnitude(v)) * v;
+}
+
+/**
+ * Cross product, a cross b.
+ */
+template <typename T>
+constexpr Vec<3, T> cross(const Vec<3, T>& a, const Vec<3, T>& b)
+{
+    return Vec<3, T>(
+        a.y()*b.z() - a.z()*b.y(),
+        a.z()*b.x() - a.x()*b.z(),
+        a.x()*b.y() - a.y()*b.x()
+    );
+}
+
+}
+
+#include <jelly/math/vec_simd.hpp>
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef _JELLY_MATH_VEC_SIMD_HPP_
+#define _JELLY_MATH_VEC_SIMD_HPP_
+
+#include <jelly/math/simd_ops.hpp>
+#include <jelly/math/vec.hpp>
+
+namespace jelly {
+
+namespace detail {
+
+inline namespace JELLY_SIMD_NAMESPACE {
+
+
+inline float vec4_dot_scalar(const float* a, const float* b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+}
+
+
+// The element-wise operations round exactly like their scalar counterparts,
+// so only the dot product is verified
+
+#if !defined(JELLY_SIMD_SCALAR)
+
+inline void vec4_add(const float* a, const float* b, float* o)
+{
+    using namespace jelly::simd;
+    store_aligned(o, add(load_aligned(a), load_aligned(b)));
+}
+
+
+inline void vec4_sub(const float* a, const float* b, float* o)
+{
+    using namespace jelly::simd;
+    store_aligned(o, sub(load_aligned(a), load_aligned(b)));
+}
+
+
+inline void vec4_scale(const float* v, float s, float* o)
+{
+    using namespace jelly::simd;
+    store_aligned(o, mul(load_aligned(v), set1(s)));
+}
+
+
+inline float vec4_dot(const float* a, const float* b)
+{
+    using namespace jelly::simd;
+    float result = sum(mul(load_aligned(a), load_aligned(b)));
+
+    if (is_verifying()) {
+        float reference = vec4_dot_scalar(a, b);
+        _verify("dot(Vec4, Vec4)", &result, &reference, 1);
+    }
+    return result;
+}
+
+#else
+
+inline void vec4_add(const float* a, const float* b, float* o)
+{
+    for (unsigned int i = 0; i < 4; ++i) {
+        o[i] = a[i] + b[i];
+    }
+}
+
+
+inline void vec4_sub(const float* a, const float* b, float* o)
+{
+    for (unsigned int i = 0; i < 4; ++i) {
+        o[i] = a[i] - b[i];
+    }
+}
+
+
+inline void vec4_scale(const float* v, float s, float* o)
+{
+    for (unsigned int i = 0; i < 4; ++i) {
+        o[i] = v[i] * s;
+    }
+}
+
+
+inline float vec4_dot(const float* a, const float* b)
+{
+    return vec4_dot_scalar(a, b);
+}
+
+#endif
+
+
+}
+
+}
+
+}
+
+#endif
@@ -10,6 +10,8 @@ namespace jelly
 class Sketch;
 class Shader;
 class Mesh;
+class ShapeBatch;
+struct ShapeInstance;
 
 /**
  * Sketch mixin that provides basic 2D rendering capabilities.
@@ -31,6 +33,13 @@ protected:
      */
     void init();
 
+    /**
+     * Renders all pending shapes and records the batching counters of the
+     * frame. Should only be called by the Sketch base class at the end of
+     * every frame.
+     */
+    void end_frame();
+
     void set_color(float r, float g, float b);
 
     void set_color(float r, float g, float b, float a);
@@ -43,23 +52,41 @@ protected:
 
     void draw_rectangle(int x1, int y1, int x2, int y2);
 
+    void fill_rounded_rectangle(int x1, int y1, int x2, int y2, int radius);
+
+    void draw_rounded_rectangle(int x1, int y1, int x2, int y2, int radius);
+
     void fill_ellipse(int x, int y, int w, int h);
 
     void draw_ellipse(int x, int y, int w, int h);
 
+    /**
+     * Returns the number of draw calls used to render shapes in the previous
+     * frame.
+     */
+    unsigned int batch_flush_count() const { return _frame_flush_count; }
+
+    /**
+     * Returns the number of shapes rendered in the previous frame.
+     */
+    unsigned int batch_shape_count() const { return _frame_shape_count; }
+
 private:
 
+    void _push_shape(const ShapeInstance& shape);
+
     Sketch* _sketch;
 
-    Shader* _fill_rectangle_shader;
-    Shader* _fill_ellipse_shader;
-    Shader* _draw_rectangle_shader;
-    Shader* _draw_ellipse_shader;
-    Mesh*   _quad_mesh;
+    Shader*     _shape_shader;
+    Mesh*       _quad_mesh;
+    ShapeBatch* _batch;
 
     Vec4 _color;
     int _stroke_size;
 
+    unsigned int _frame_flush_count;
+    unsigned int _frame_shape_count;
+
 };
 
 }
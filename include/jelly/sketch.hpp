@@ -5,12 +5,26 @@
 
 #include <jelly/window.hpp>
 #include <jelly/mixins.hpp>
+#include <jelly/gl/render_queue.hpp>
+#include <jelly/gl/uniform_buffer.hpp>
 
 namespace jelly {
 
 /**
  * Defines the abstract sketch class that serves as an entrypoint to access
  * graphics primitives.
+ *
+ * The sketch owns a per-frame uniform buffer bound to FRAME_GLOBALS_BINDING,
+ * which custom shaders can use to read the camera and frame data by
+ * declaring the following block and calling
+ * `shader.set_uniform_block("FrameGlobals", Sketch::FRAME_GLOBALS_BINDING)`:
+ *
+ *     layout (std140) uniform FrameGlobals {
+ *         mat4 u_Projection;
+ *         mat4 u_View;
+ *         vec2 u_ViewportSize;
+ *         float u_Time;
+ *     };
  */
 class Sketch :
     public CanvasMixin,
@@ -21,6 +35,11 @@ class Sketch :
 
 public:
 
+    /**
+     * The uniform buffer binding point of the FrameGlobals block.
+     */
+    static constexpr unsigned int FRAME_GLOBALS_BINDING = 0;
+
     Sketch(const Sketch&) = delete;
     Sketch& operator=(const Sketch&) = delete;
 
@@ -72,10 +91,51 @@ public:
         return _projection;
     }
 
+    const Mat4& view_mat() const {
+        return _view;
+    }
+
+    /**
+     * Returns the render queue of the sketch. Draws recorded during draw()
+     * are sorted and rendered at the end of the frame, after the draws made
+     * directly on the context.
+     */
+    RenderQueue& render_queue() {
+        return _render_queue;
+    }
+
+    /**
+     * Sets the projection matrix of the frame globals. Shapes rendered before
+     * the change keep the previous projection.
+     */
+    void set_projection_mat(const Mat4& projection);
+
+    /**
+     * Sets the view matrix of the frame globals. Shapes rendered before the
+     * change keep the previous view.
+     */
+    void set_view_mat(const Mat4& view);
+
 private:
 
+    /**
+     * Uploads changed frame globals, flushing pending draws first so they
+     * still read the previous values.
+     */
+    void _upload_frame_globals();
+
     std::shared_ptr<Window> _window;
     Mat4 _projection;
+    Mat4 _view;
+    double _time;
+
+    RenderQueue _render_queue;
+
+    std::unique_ptr<UniformBuffer> _frame_globals;
+    unsigned int _projection_offset;
+    unsigned int _view_offset;
+    unsigned int _viewport_size_offset;
+    unsigned int _time_offset;
 
 };
 
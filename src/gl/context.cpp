@@ -1,76 +1,484 @@
 #include <jelly/gl/context.hpp>
 
+#include <stdexcept>
+
 #include <GL/glew.h>
 
 #include <jelly/window.hpp>
 
+namespace {
+
+
+/**
+ * Marks a tracked program whose state is unknown, forcing the next use.
+ */
+const unsigned int UNKNOWN_PROGRAM = ~0u;
+
+
+/**
+ * The initial size in bytes of the transient data of a frame.
+ */
+const unsigned int TRANSIENT_FRAME_SIZE = 1 << 20;
+
+
+}
+
+
 namespace jelly {
 
 
+Context* Context::_current = nullptr;
+
+
 Context::Context(Window* owner) :
     _owner(owner),
-    _activeShader(nullptr)
+    _flushing(false),
+    _activeShader(nullptr),
+    _program(0),
+    _vertexArray(0),
+    _framebuffer(0),
+    _activeTexture(0),
+    _transientBuffer(TRANSIENT_FRAME_SIZE),
+    _blending(true),
+    _depthTest(false),
+    _depthWrite(true),
+    _faceCulling(true),
+    _stencilTest(true),
+    _scissorTest(false),
+    _blendSrc(GL_SRC_ALPHA),
+    _blendDst(GL_ONE_MINUS_SRC_ALPHA),
+    _scissor{0, 0, 0, 0},
+    _clearColor(0.0f, 0.0f, 0.0f),
+    _stats{0, 0},
+    _frameStats{0, 0}
 {
     Vec2 windowSize = owner->get_size();
     _vpWidth = windowSize.x();
     _vpHeight = windowSize.y();
+    _scissor[2] = _vpWidth;
+    _scissor[3] = _vpHeight;
+
+    // Set default rendering flags optimized for 2D rendering, matching the
+    // tracked state above
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_STENCIL_TEST);
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_SCISSOR_TEST);
+    glScissor(0, 0, _vpWidth, _vpHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    GLint units = 16;
+    glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &units);
+    _textureUnits.resize(units, TextureUnit{0, 0});
+
+    // Let the driver compile deferred shaders on as many threads as it likes
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    } else if (GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+
+    _current = this;
 }
 
 
-Context::~Context() {}
+Context::~Context() {
+    if (_current == this) {
+        _current = nullptr;
+    }
+}
 
 
 void Context::activate_shader(Shader& shader) {
     Shader* ptr = &shader;
 
     if (_activeShader != ptr) {
+        // Deferred shaders block here until the driver is done compiling
+        shader._finalize();
+        flush();
         if (_activeShader != nullptr) {
             _activeShader->_deactivate();
         }
         _activeShader = ptr;
+        _use_program(shader.get_gl_handle());
         ptr->_activate(this);
+    } else {
+        _stats.elided += 1;
     }
 }
 
 
-void Context::render_mesh(const Mesh& mesh) {
-    mesh._render();
+void Context::render_mesh(const Mesh& mesh, unsigned int lod) {
+    if (lod >= mesh.get_lod_count()) {
+        throw std::runtime_error("Mesh level of detail out of range");
+    }
+    flush();
+    _bind_vertex_array(mesh._vao);
+    mesh._render(lod);
+}
+
+
+void Context::render_mesh_instanced(
+    const Mesh& mesh,
+    const VertexFormat& format,
+    const void* instances,
+    unsigned int count,
+    unsigned int lod
+) {
+    if (lod >= mesh.get_lod_count()) {
+        throw std::runtime_error("Mesh level of detail out of range");
+    }
+    if (format.get_stream_count() != 1) {
+        throw std::runtime_error("Instance format must have a single stream");
+    }
+    for (const VertexFormat::Attribute& attribute : format.get_attributes()) {
+        if (mesh.get_vertex_format().get_attribute(attribute.location)) {
+            throw std::runtime_error("Instance attribute location used by the mesh");
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+
+    flush();
+    TransientRange range = _transientBuffer.upload(instances, count * format.get_stride(0));
+    _bind_vertex_array(mesh._get_instance_vao());
+    mesh._bind_instances(format, range.buffer, range.offset);
+    mesh._render(lod, count);
 }
 
 
 void Context::bind_texture(const Texture& tex, unsigned int index) {
-    // TODO avoid binding if texture is already bound
-    tex._bind(index);
+    if (index >= _textureUnits.size()) {
+        throw std::runtime_error("Texture unit out of range");
+    }
+
+    TextureUnit& unit = _textureUnits[index];
+    unsigned int target = tex._gl_target();
+    unsigned int& bound = target == GL_TEXTURE_CUBE_MAP ? unit.textureCube : unit.texture2D;
+    if (bound == tex.get_gl_handle()) {
+        _stats.elided += 1;
+        return;
+    }
+
+    flush();
+    _set_active_texture(index);
+    glBindTexture(target, tex.get_gl_handle());
+    bound = tex.get_gl_handle();
+    _stats.issued += 1;
+}
+
+
+void Context::bind_uniform_buffer(const UniformBuffer& buffer, unsigned int binding) {
+    if (binding >= _boundUniformBuffers.size()) {
+        _boundUniformBuffers.resize(binding + 1, 0);
+    }
+    if (_boundUniformBuffers[binding] != buffer.get_gl_handle()) {
+        flush();
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.get_gl_handle());
+        _boundUniformBuffers[binding] = buffer.get_gl_handle();
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::bind_uniform_range(const TransientRange& range, unsigned int binding) {
+    if (binding >= _boundUniformBuffers.size()) {
+        _boundUniformBuffers.resize(binding + 1, 0);
+    }
+
+    // Ranges always differ, so their binds are never elided
+    flush();
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, range.buffer, range.offset, range.size);
+    _boundUniformBuffers[binding] = range.buffer;
+    _stats.issued += 1;
+}
+
+
+void Context::stream_uniform_buffer(const UniformBuffer& buffer, unsigned int binding) {
+    TransientRange range = _transientBuffer.upload(
+        buffer.get_data(),
+        buffer.get_size(),
+        _transientBuffer.get_uniform_alignment()
+    );
+    bind_uniform_range(range, binding);
 }
 
 
 void Context::clear(const Vec3& color) {
-    glClearColor(color.x(), color.y(), color.z(), 1.0f);
+    flush();
+    if (color.x() != _clearColor.x() || color.y() != _clearColor.y() || color.z() != _clearColor.z()) {
+        glClearColor(color.x(), color.y(), color.z(), 1.0f);
+        _clearColor = color;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
 
 void Context::set_framebuffer(const Framebuffer& fb) {
-    fb._bind();
+    if (!fb._complete) {
+        throw std::runtime_error("Attempt to use incorrectly formed framebuffer");
+    }
+    _bind_framebuffer(fb.get_gl_handle());
 
     _set_viewport(fb.get_width(), fb.get_height());
 }
 
 
 void Context::reset_framebuffer() {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    _bind_framebuffer(0);
 
     _set_viewport(_owner->get_width(), _owner->get_height());
 }
 
+
+void Context::set_blending(bool enabled) {
+    _set_capability(GL_BLEND, _blending, enabled);
+}
+
+
+void Context::set_blend_func(unsigned int src, unsigned int dst) {
+    if (src != _blendSrc || dst != _blendDst) {
+        flush();
+        glBlendFunc(src, dst);
+        _blendSrc = src;
+        _blendDst = dst;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::set_depth_test(bool enabled) {
+    _set_capability(GL_DEPTH_TEST, _depthTest, enabled);
+}
+
+
+void Context::set_depth_write(bool enabled) {
+    if (enabled != _depthWrite) {
+        flush();
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+        _depthWrite = enabled;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::set_face_culling(bool enabled) {
+    _set_capability(GL_CULL_FACE, _faceCulling, enabled);
+}
+
+
+void Context::set_stencil_test(bool enabled) {
+    _set_capability(GL_STENCIL_TEST, _stencilTest, enabled);
+}
+
+
+void Context::set_scissor_test(bool enabled) {
+    _set_capability(GL_SCISSOR_TEST, _scissorTest, enabled);
+}
+
+
+void Context::set_scissor(int x, int y, int width, int height) {
+    if (x != _scissor[0] || y != _scissor[1] || width != _scissor[2] || height != _scissor[3]) {
+        flush();
+        glScissor(x, y, width, height);
+        _scissor[0] = x;
+        _scissor[1] = y;
+        _scissor[2] = width;
+        _scissor[3] = height;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::set_on_flush(flush_callback_t cb) {
+    _flushCallback = cb;
+}
+
+
+void Context::flush() {
+    if (_flushCallback && !_flushing) {
+        _flushing = true;
+        _flushCallback(*this);
+        _flushing = false;
+    }
+}
+
+
 void Context::_set_viewport(int width, int height) {
     if (width != _vpWidth || height != _vpHeight) {
+        flush();
         glViewport(0, 0, width, height);
         _vpWidth = width;
         _vpHeight = height;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::_use_program(unsigned int program) {
+    if (program != _program) {
+        glUseProgram(program);
+        _program = program;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::_bind_vertex_array(unsigned int vao) {
+    if (vao != _vertexArray) {
+        glBindVertexArray(vao);
+        _vertexArray = vao;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::_bind_framebuffer(unsigned int fb) {
+    if (fb != _framebuffer) {
+        flush();
+        glBindFramebuffer(GL_FRAMEBUFFER, fb);
+        _framebuffer = fb;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::_set_active_texture(unsigned int index) {
+    if (index != _activeTexture) {
+        glActiveTexture(GL_TEXTURE0 + index);
+        _activeTexture = index;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::_set_capability(unsigned int cap, bool& current, bool enabled) {
+    if (enabled != current) {
+        flush();
+        if (enabled) {
+            glEnable(cap);
+        } else {
+            glDisable(cap);
+        }
+        current = enabled;
+        _stats.issued += 1;
+    } else {
+        _stats.elided += 1;
+    }
+}
+
+
+void Context::_end_frame() {
+    _transientBuffer._end_frame();
+    _frameStats = _stats;
+    _stats = StateStats{0, 0};
+}
+
+
+void Context::_notify_vertex_array(unsigned int vao) {
+    if (_current) {
+        _current->_vertexArray = vao;
+    }
+}
+
+
+void Context::_notify_texture(unsigned int target, unsigned int texture) {
+    if (_current) {
+        TextureUnit& unit = _current->_textureUnits[_current->_activeTexture];
+        if (target == GL_TEXTURE_CUBE_MAP) {
+            unit.textureCube = texture;
+        } else {
+            unit.texture2D = texture;
+        }
+    }
+}
+
+
+void Context::_notify_framebuffer(unsigned int fb) {
+    if (_current) {
+        _current->_framebuffer = fb;
+    }
+}
+
+
+void Context::_notify_deleted_vertex_array(unsigned int vao) {
+    // Deleting a bound object reverts the binding to zero
+    if (_current && _current->_vertexArray == vao) {
+        _current->_vertexArray = 0;
+    }
+}
+
+
+void Context::_notify_deleted_texture(unsigned int texture) {
+    if (_current) {
+        for (TextureUnit& unit : _current->_textureUnits) {
+            if (unit.texture2D == texture) {
+                unit.texture2D = 0;
+            }
+            if (unit.textureCube == texture) {
+                unit.textureCube = 0;
+            }
+        }
+    }
+}
+
+
+void Context::_notify_deleted_framebuffer(unsigned int fb) {
+    if (_current && _current->_framebuffer == fb) {
+        _current->_framebuffer = 0;
+    }
+}
+
+
+void Context::_notify_deleted_buffer(unsigned int buffer) {
+    if (_current) {
+        for (unsigned int& bound : _current->_boundUniformBuffers) {
+            if (bound == buffer) {
+                bound = 0;
+            }
+        }
     }
 }
 
 
+void Context::_notify_deleted_shader(Shader* shader) {
+    // A deleted program stays in use until another one is used, and its name
+    // may be reused by a new program, so the next use must always be issued
+    if (_current && _current->_activeShader == shader) {
+        _current->_activeShader = nullptr;
+        _current->_program = UNKNOWN_PROGRAM;
+    }
+}
+
+
+unsigned int Context::_bound_framebuffer() {
+    return _current ? _current->_framebuffer : 0;
+}
+
+
 }
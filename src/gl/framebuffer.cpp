@@ -2,10 +2,13 @@
 
 #include <stdexcept>
 
+#include <jelly/gl/context.hpp>
+
 namespace jelly {
 
 Framebuffer::Framebuffer() :
     _handle(0),
+    _complete(false),
     _width(-1),
     _height(-1)
 {
@@ -15,6 +18,7 @@ Framebuffer::Framebuffer() :
 
 Framebuffer::~Framebuffer() {
     glDeleteFramebuffers(1, &_handle);
+    Context::_notify_deleted_framebuffer(_handle);
 }
 
 
@@ -29,7 +33,7 @@ void Framebuffer::attach_color(const Texture& tex, unsigned int i) {
     glBindFramebuffer(GL_FRAMEBUFFER, _handle);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, tex.get_gl_handle(), 0);
     _usedColorBuffers.emplace_back(GL_COLOR_ATTACHMENT0 + i);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    _update();
 }
 
 
@@ -43,7 +47,7 @@ void Framebuffer::attach_depth(const Texture& tex) {
 
     glBindFramebuffer(GL_FRAMEBUFFER, _handle);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, tex.get_gl_handle(), 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    _update();
 }
 
 
@@ -57,19 +61,22 @@ void Framebuffer::attach_depth_stencil(const Texture& tex) {
 
     glBindFramebuffer(GL_FRAMEBUFFER, _handle);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, tex.get_gl_handle(), 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    _update();
 }
 
 
-void Framebuffer::_bind() const {
-    glBindFramebuffer(GL_FRAMEBUFFER, _handle);
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
-        glDrawBuffers(_usedColorBuffers.size(), _usedColorBuffers.data());
+void Framebuffer::_update() {
+    // The draw buffers are framebuffer state, so they only have to be set when
+    // the attachments change rather than on every bind
+    if (_usedColorBuffers.empty()) {
+        glDrawBuffer(GL_NONE);
     } else {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        throw std::runtime_error("Attempt to use incorrectly formed framebuffer");
+        glDrawBuffers(_usedColorBuffers.size(), _usedColorBuffers.data());
     }
+    _complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    // Restore the render target of the context
+    glBindFramebuffer(GL_FRAMEBUFFER, Context::_bound_framebuffer());
 }
 
 
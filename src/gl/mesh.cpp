@@ -1,5 +1,102 @@
 #include <jelly/gl/mesh.hpp>
 
+#include <cstring>
+#include <stdexcept>
+
+#include <jelly/gl/context.hpp>
+#include <jelly/gl/mesh_optimizer.hpp>
+#include <jelly/math/common.hpp>
+
+
+namespace {
+
+
+/**
+ * Returns true if all indices fit in 16 bits.
+ */
+bool fits_16_bits(const std::vector<unsigned int>& indices) {
+    for (unsigned int index : indices) {
+        if (index > 0xffff) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+unsigned int index_size(unsigned int indexType) {
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(unsigned int);
+}
+
+
+/**
+ * Makes room for size bytes in a buffer, bound to GL_COPY_WRITE_BUFFER so
+ * that the element buffer binding of the current vertex array is untouched.
+ * Buffers grow geometrically and keep their first bytes, or are orphaned when
+ * none are kept, so that the driver need not wait for draws still using them.
+ *
+ * \returns
+ *     The new capacity of the buffer in bytes.
+ */
+unsigned int reserve_buffer(unsigned int buffer, unsigned int capacity, unsigned int size, unsigned int keep,
+                            unsigned int usage) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (size <= capacity) {
+        if (keep == 0 && capacity > 0) {
+            glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, usage);
+        }
+        return capacity;
+    }
+
+    unsigned int grown = MAX(size, capacity + capacity / 2);
+    if (keep == 0) {
+        glBufferData(GL_COPY_WRITE_BUFFER, grown, nullptr, usage);
+        return grown;
+    }
+
+    // Reallocate in place, through a temporary copy, so that the vertex
+    // array keeps referencing the buffer
+    unsigned int copy;
+    glGenBuffers(1, &copy);
+    glBindBuffer(GL_COPY_READ_BUFFER, copy);
+    glBufferData(GL_COPY_READ_BUFFER, keep, nullptr, GL_STREAM_COPY);
+    glCopyBufferSubData(GL_COPY_WRITE_BUFFER, GL_COPY_READ_BUFFER, 0, 0, keep);
+    glBufferData(GL_COPY_WRITE_BUFFER, grown, nullptr, usage);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, keep);
+    glDeleteBuffers(1, &copy);
+    return grown;
+}
+
+
+/**
+ * Points an attribute of the bound vertex array at the bound array buffer,
+ * keeping integer attributes as integers.
+ */
+void set_attribute_pointer(const jelly::VertexFormat::Attribute& attribute, unsigned int stride, unsigned int offset) {
+    if (attribute.integer) {
+        glVertexAttribIPointer(
+            attribute.location,
+            attribute.components,
+            (GLenum)attribute.type,
+            stride,
+            (void*)(std::size_t)offset
+        );
+    }
+    else {
+        glVertexAttribPointer(
+            attribute.location,
+            attribute.components,
+            (GLenum)attribute.type,
+            attribute.normalized ? GL_TRUE : GL_FALSE,
+            stride,
+            (void*)(std::size_t)offset
+        );
+    }
+}
+
+
+}
+
 
 namespace jelly {
 
@@ -139,10 +236,56 @@ Mesh* Mesh::sphere_mesh(unsigned int latr, unsigned int lngr, float rad)
         }
     }
 
+    // The rows of quads reuse few vertices from the previous row in the cache
+    MeshOptimizer::optimize(vertices, normals, uvs, indices);
+
     return new Mesh(vertices, normals, uvs, indices);
 }
 
 
+Mesh* Mesh::compressed_mesh(
+    const std::vector<Vec3>& vertices,
+    const std::vector<Vec3>& normals,
+    const std::vector<Vec2>& uvs,
+    const std::vector<unsigned int>& indices,
+    const VertexCompression& compression,
+    CompressionReport* report,
+    unsigned int mode
+) {
+    Mat4 positionTransform;
+    std::vector<unsigned char> data = compression.compress(vertices, normals, uvs, positionTransform, report);
+    Mesh* mesh = new Mesh(compression.get_format(), data.data(), vertices.size(), indices, mode);
+    mesh->_positionTransform = positionTransform;
+
+    // Bound the original positions, which quantized ones cannot be read as
+    if (compression.get_position() != VertexCompression::Position::FLOAT) {
+        mesh->_compute_bounds(vertices);
+    }
+    return mesh;
+}
+
+
+Mesh* Mesh::lod_mesh(
+    const std::vector<Vec3>& vertices,
+    const std::vector<Vec3>& normals,
+    const std::vector<Vec2>& uvs,
+    const std::vector<unsigned int>& indices,
+    unsigned int levels,
+    float ratio
+) {
+    std::vector<Vec3> lodVertices = vertices;
+    std::vector<Vec3> lodNormals = normals;
+    std::vector<Vec2> lodUvs = uvs;
+    std::vector<unsigned int> lodIndices = indices;
+    MeshOptimizer::optimize(lodVertices, lodNormals, lodUvs, lodIndices);
+    std::vector<MeshLod> lods = MeshOptimizer::generate_lods(lodIndices, lodVertices, levels, ratio);
+
+    Mesh* mesh = new Mesh(lodVertices, lodNormals, lodUvs, lodIndices);
+    mesh->set_lods(lods);
+    return mesh;
+}
+
+
 Mesh::Mesh(
     const std::vector<Vec3>& vertices,
     const std::vector<Vec3>& normals,
@@ -150,15 +293,21 @@ Mesh::Mesh(
     const std::vector<unsigned int> indices,
     unsigned int mode
 ) :
+    _format(VertexFormat::standard()),
+    _numVertices(vertices.size()),
     _numIndices(indices.size()),
-    _vbo(0),
     _ebo(0),
+    _eboCapacity(0),
     _vao(0),
-    _renderMode(mode)
+    _indexType(GL_UNSIGNED_INT),
+    _usage(Usage::STATIC),
+    _renderMode(mode),
+    _positionTransform(1.0f),
+    _instanceVao(0)
 {
     // Combine the vertex info into a single buffer and store in the format
     // {x y z nx ny nz u v ...}
-    float* buffer = new float[8 * vertices.size()];
+    std::vector<float> buffer(8 * vertices.size());
 
     for (unsigned int i = 0; i < vertices.size(); ++i)
     {
@@ -175,52 +324,146 @@ Mesh::Mesh(
         buffer[i*8+7] = uv.y();
     }
 
-    // Create the vertex attribute object
-    glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    std::vector<const void*> streams = {buffer.data()};
+    _create(streams, indices);
+}
 
-    // Create the vertex buffer object and assign it
-    glGenBuffers(1, &_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER,
-        vertices.size() * sizeof(float) * 8,
-        buffer,
-        GL_STATIC_DRAW
-    );
-
-    // Create the element buffer object and assign it
-    glGenBuffers(1, &_ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        _numIndices * sizeof(unsigned int),
-        indices.data(),
-        GL_STATIC_DRAW
-    );
-
-    // Configure vertex attributes
-    // Vertices attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Normals attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // Texture coordinates attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
-    delete [] buffer;
+Mesh::Mesh(
+    const VertexFormat& format,
+    const void* vertices,
+    unsigned int vertexCount,
+    const std::vector<unsigned int>& indices,
+    unsigned int mode
+) :
+    _format(format),
+    _numVertices(vertexCount),
+    _numIndices(indices.size()),
+    _ebo(0),
+    _eboCapacity(0),
+    _vao(0),
+    _indexType(GL_UNSIGNED_INT),
+    _usage(Usage::STATIC),
+    _renderMode(mode),
+    _positionTransform(1.0f),
+    _instanceVao(0)
+{
+    if (format.get_stream_count() != 1) {
+        throw std::runtime_error("Interleaved mesh data requires a single stream format");
+    }
+    std::vector<const void*> streams = {vertices};
+    _create(streams, indices);
+}
+
+
+Mesh::Mesh(
+    const VertexFormat& format,
+    const std::vector<const void*>& streams,
+    unsigned int vertexCount,
+    const std::vector<unsigned int>& indices,
+    unsigned int mode
+) :
+    _format(format),
+    _numVertices(vertexCount),
+    _numIndices(indices.size()),
+    _ebo(0),
+    _eboCapacity(0),
+    _vao(0),
+    _indexType(GL_UNSIGNED_INT),
+    _usage(Usage::STATIC),
+    _renderMode(mode),
+    _positionTransform(1.0f),
+    _instanceVao(0)
+{
+    if (streams.size() != format.get_stream_count()) {
+        throw std::runtime_error("Mesh stream count does not match the vertex format");
+    }
+    _create(streams, indices);
+}
+
+
+Mesh::Mesh(
+    const VertexFormat& format,
+    const void* vertices,
+    unsigned int vertexCount,
+    const std::vector<std::uint16_t>& indices,
+    unsigned int mode
+) :
+    _format(format),
+    _numVertices(vertexCount),
+    _numIndices(indices.size()),
+    _ebo(0),
+    _eboCapacity(0),
+    _vao(0),
+    _indexType(GL_UNSIGNED_INT),
+    _usage(Usage::STATIC),
+    _renderMode(mode),
+    _positionTransform(1.0f),
+    _instanceVao(0)
+{
+    if (format.get_stream_count() != 1) {
+        throw std::runtime_error("Interleaved mesh data requires a single stream format");
+    }
+    std::vector<const void*> streams = {vertices};
+    _create(streams, indices.data(), GL_UNSIGNED_SHORT);
+}
+
+
+Mesh::Mesh(
+    const VertexFormat& format,
+    const std::vector<const void*>& streams,
+    unsigned int vertexCount,
+    const std::vector<std::uint16_t>& indices,
+    unsigned int mode
+) :
+    _format(format),
+    _numVertices(vertexCount),
+    _numIndices(indices.size()),
+    _ebo(0),
+    _eboCapacity(0),
+    _vao(0),
+    _indexType(GL_UNSIGNED_INT),
+    _usage(Usage::STATIC),
+    _renderMode(mode),
+    _positionTransform(1.0f),
+    _instanceVao(0)
+{
+    if (streams.size() != format.get_stream_count()) {
+        throw std::runtime_error("Mesh stream count does not match the vertex format");
+    }
+    _create(streams, indices.data(), GL_UNSIGNED_SHORT);
+}
+
+
+Mesh::Mesh(const VertexFormat& format, Usage usage, unsigned int mode) :
+    _format(format),
+    _numVertices(0),
+    _numIndices(0),
+    _ebo(0),
+    _eboCapacity(0),
+    _vao(0),
+    _indexType(GL_UNSIGNED_SHORT),
+    _usage(usage),
+    _renderMode(mode),
+    _positionTransform(1.0f),
+    _instanceVao(0)
+{
+    std::vector<const void*> streams(format.get_stream_count(), nullptr);
+    _create(streams, nullptr, GL_UNSIGNED_SHORT);
 }
 
 
 Mesh::~Mesh() {
     if (_vao) {
         glDeleteVertexArrays(1, &_vao);
+        Context::_notify_deleted_vertex_array(_vao);
+    }
+    if (_instanceVao) {
+        glDeleteVertexArrays(1, &_instanceVao);
+        Context::_notify_deleted_vertex_array(_instanceVao);
     }
-    if (_vbo) {
-        glDeleteBuffers(1, &_vbo);
+    if (!_vbos.empty()) {
+        glDeleteBuffers(_vbos.size(), _vbos.data());
     }
     if (_ebo) {
         glDeleteBuffers(1, &_ebo);
@@ -228,11 +471,305 @@ Mesh::~Mesh() {
 }
 
 
-void Mesh::_render() const {
+void Mesh::_create(const std::vector<const void*>& streams, const std::vector<unsigned int>& indices) {
+    // Narrow the indices to 16 bits when they fit, which halves their memory
+    // and bandwidth
+    if (fits_16_bits(indices)) {
+        std::vector<std::uint16_t> narrow(indices.begin(), indices.end());
+        _create(streams, narrow.data(), GL_UNSIGNED_SHORT);
+    }
+    else {
+        _create(streams, indices.data(), GL_UNSIGNED_INT);
+    }
+}
+
+
+void Mesh::_create(const std::vector<const void*>& streams, const void* indices, unsigned int indexType) {
+    _indexType = indexType;
+    _compute_bounds(streams);
+
+    // Create a vertex buffer object per stream
+    _vbos.resize(streams.size());
+    _vboCapacities.resize(streams.size());
+    glGenBuffers(_vbos.size(), _vbos.data());
+    for (unsigned int i = 0; i < _vbos.size(); ++i) {
+        _vboCapacities[i] = _numVertices * _format.get_stride(i);
+        glBindBuffer(GL_ARRAY_BUFFER, _vbos[i]);
+        glBufferData(GL_ARRAY_BUFFER, _vboCapacities[i], streams[i], (GLenum)_usage);
+    }
+
+    // Create the element buffer object, uploaded through GL_COPY_WRITE_BUFFER
+    // since the element buffer binding belongs to the bound vertex array,
+    // which may be the last drawn mesh's
+    _eboCapacity = _numIndices * index_size(indexType);
+    glGenBuffers(1, &_ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, _eboCapacity, indices, (GLenum)_usage);
+
+    // Create the vertex attribute object, which also captures the element
+    // buffer binding
+    glGenVertexArrays(1, &_vao);
+    glBindVertexArray(_vao);
+    _bind_attributes();
+    glBindVertexArray(0);
+    Context::_notify_vertex_array(0);
+}
+
+
+void Mesh::set_vertices(const void* data, unsigned int count, unsigned int stream) {
+    if (stream >= _vbos.size()) {
+        throw std::runtime_error("Mesh stream out of range");
+    }
+    unsigned int size = count * _format.get_stride(stream);
+    _vboCapacities[stream] = reserve_buffer(_vbos[stream], _vboCapacities[stream], size, 0, (GLenum)_usage);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, data);
+    _numVertices = count;
+
+    std::vector<Vec3> positions;
+    if (_read_positions(data, stream, count, positions)) {
+        _compute_bounds(positions);
+    }
+}
+
+
+void Mesh::update_vertices(const void* data, unsigned int first, unsigned int count, unsigned int stream) {
+    if (stream >= _vbos.size()) {
+        throw std::runtime_error("Mesh stream out of range");
+    }
+    unsigned int stride = _format.get_stride(stream);
+    unsigned int keep = first + count < _numVertices ? _numVertices : MIN(_numVertices, first);
+    _vboCapacities[stream] = reserve_buffer(_vbos[stream], _vboCapacities[stream], (first + count) * stride,
+                                            keep * stride, (GLenum)_usage);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, first * stride, count * stride, data);
+    _numVertices = MAX(_numVertices, first + count);
+
+    // Only grow the bounds, as the replaced vertices are unknown
+    std::vector<Vec3> positions;
+    if (count > 0 && _read_positions(data, stream, count, positions)) {
+        Aabb previous = _bounds;
+        Sphere sphere = _boundingSphere;
+        _compute_bounds(positions);
+        if (!previous.is_empty()) {
+            _bounds.expand(previous);
+            Vec3 center = _bounds.center();
+            float radius = magnitude(sphere.center - center) + sphere.radius;
+            for (const Vec3& p : positions) {
+                radius = MAX(radius, magnitude(p - center));
+            }
+            _boundingSphere = Sphere(center, radius);
+        }
+    }
+}
+
+
+void Mesh::set_indices(const std::vector<unsigned int>& indices) {
+    if (fits_16_bits(indices)) {
+        std::vector<std::uint16_t> narrow(indices.begin(), indices.end());
+        _set_indices(narrow.data(), narrow.size(), GL_UNSIGNED_SHORT);
+    }
+    else {
+        _set_indices(indices.data(), indices.size(), GL_UNSIGNED_INT);
+    }
+}
+
+
+void Mesh::set_indices(const std::vector<std::uint16_t>& indices) {
+    _set_indices(indices.data(), indices.size(), GL_UNSIGNED_SHORT);
+}
+
+
+void Mesh::update_indices(const std::vector<unsigned int>& indices, unsigned int first) {
+    if (_indexType == GL_UNSIGNED_SHORT && !fits_16_bits(indices)) {
+        throw std::runtime_error("Mesh indices do not fit in 16 bits, use set_indices()");
+    }
+
+    unsigned int size = index_size(_indexType);
+    unsigned int last = first + indices.size();
+    unsigned int keep = last < _numIndices ? _numIndices : MIN(_numIndices, first);
+    _eboCapacity = reserve_buffer(_ebo, _eboCapacity, last * size, keep * size, (GLenum)_usage);
+
+    if (_indexType == GL_UNSIGNED_SHORT) {
+        std::vector<std::uint16_t> narrow(indices.begin(), indices.end());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, first * size, narrow.size() * size, narrow.data());
+    }
+    else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, first * size, indices.size() * size, indices.data());
+    }
+    _numIndices = MAX(_numIndices, last);
+}
+
+
+void Mesh::set_index_count(unsigned int count) {
+    if (count * index_size(_indexType) > _eboCapacity) {
+        throw std::runtime_error("Mesh index count exceeds the index buffer");
+    }
+    _numIndices = count;
+    _lods.clear();
+}
+
+
+void Mesh::_set_indices(const void* indices, unsigned int count, unsigned int indexType) {
+    // The previous indices may be of the other type, so they are orphaned
+    // rather than kept
+    unsigned int size = count * index_size(indexType);
+    _eboCapacity = reserve_buffer(_ebo, _eboCapacity, size, 0, (GLenum)_usage);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, indices);
+    _indexType = indexType;
+    _numIndices = count;
+    _lods.clear();
+}
+
+
+void Mesh::set_lods(const std::vector<MeshLod>& lods) {
+    for (const MeshLod& lod : lods) {
+        if (lod.first > _numIndices || lod.count > _numIndices - lod.first) {
+            throw std::runtime_error("Mesh level of detail outside of the indices");
+        }
+    }
+    _lods = lods;
+}
+
+
+unsigned int Mesh::select_lod(
+    const Mat4& modelView,
+    const Mat4& projection,
+    float viewportHeight,
+    float pixelError
+) const {
+    if (_lods.size() < 2 || _boundingSphere.radius <= 0.0f) {
+        return 0;
+    }
+
+    // The clip w of the nearest point of the sphere, which is its depth for
+    // perspective projections and 1 for orthographic ones
+    Sphere sphere = transform(modelView, _boundingSphere);
+    float w = projection(3, 0) * sphere.center.x() + projection(3, 1) * sphere.center.y()
+        + projection(3, 2) * sphere.center.z() + projection(3, 3);
+    w -= sphere.radius * fabsf(projection(3, 2));
+    if (w <= 0.0f) {
+        return 0;
+    }
+
+    float scale = sphere.radius / _boundingSphere.radius;
+    float pixels = 0.5f * viewportHeight * projection(1, 1) * scale / w;
+    unsigned int lod = 0;
+    while (lod + 1 < _lods.size() && _lods[lod + 1].error * pixels <= pixelError) {
+        lod += 1;
+    }
+    return lod;
+}
+
+
+bool Mesh::_read_positions(const void* data, unsigned int stream, unsigned int count,
+                          std::vector<Vec3>& positions) const {
+    const VertexFormat::Attribute* position = _format.get_attribute(0);
+    if (!position || position->stream != stream || position->type != VertexFormat::Type::FLOAT
+            || position->components < 2) {
+        return false;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)data + position->offset;
+    unsigned int stride = _format.get_stride(stream);
+    unsigned int components = MIN(position->components, 3u);
+    positions.assign(count, Vec3());
+    for (unsigned int i = 0; i < count; ++i) {
+        std::memcpy(positions[i].data(), bytes + i * stride, components * sizeof(float));
+    }
+    return true;
+}
+
+
+void Mesh::_compute_bounds(const std::vector<const void*>& streams) {
+    const VertexFormat::Attribute* position = _format.get_attribute(0);
+    std::vector<Vec3> positions;
+    if (position && _numVertices > 0
+            && _read_positions(streams[position->stream], position->stream, _numVertices, positions)) {
+        _compute_bounds(positions);
+    }
+}
+
+
+void Mesh::_compute_bounds(const std::vector<Vec3>& positions) {
+    _bounds = Aabb();
+    for (const Vec3& p : positions) {
+        _bounds.expand(p);
+    }
+    if (positions.empty()) {
+        return;
+    }
+
+    // Bound the vertices with a sphere around the center of the box, which is
+    // tighter than the sphere through its corners for round meshes
+    Vec3 center = _bounds.center();
+    float radius2 = 0.0f;
+    for (const Vec3& p : positions) {
+        Vec3 d = p - center;
+        if (dot(d, d) > radius2) {
+            radius2 = dot(d, d);
+        }
+    }
+    _boundingSphere = Sphere(center, sqrtf(radius2));
+}
+
+
+void Mesh::_bind_attributes() const {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+    for (const VertexFormat::Attribute& attribute : _format.get_attributes()) {
+        glBindBuffer(GL_ARRAY_BUFFER, _vbos[attribute.stream]);
+        set_attribute_pointer(attribute, _format.get_stride(attribute.stream), attribute.offset);
+        glEnableVertexAttribArray(attribute.location);
+    }
+}
+
+
+unsigned int Mesh::_get_instance_vao() const {
+    if (!_instanceVao) {
+        glGenVertexArrays(1, &_instanceVao);
+        glBindVertexArray(_instanceVao);
+        _bind_attributes();
+        Context::_notify_vertex_array(_instanceVao);
+    }
+    return _instanceVao;
+}
+
+
+void Mesh::_bind_instances(const VertexFormat& format, unsigned int buffer, unsigned int offset) const {
+    const std::vector<VertexFormat::Attribute>& attributes = format.get_attributes();
+
+    // Switch the instance attributes when the format changes
+    bool changed = attributes.size() != _instanceLocations.size();
+    for (unsigned int i = 0; !changed && i < attributes.size(); ++i) {
+        changed = attributes[i].location != _instanceLocations[i];
+    }
+    if (changed) {
+        for (unsigned int location : _instanceLocations) {
+            glDisableVertexAttribArray(location);
+        }
+        _instanceLocations.clear();
+        for (const VertexFormat::Attribute& attribute : attributes) {
+            glVertexAttribDivisor(attribute.location, 1);
+            glEnableVertexAttribArray(attribute.location);
+            _instanceLocations.push_back(attribute.location);
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (const VertexFormat::Attribute& attribute : attributes) {
+        set_attribute_pointer(attribute, format.get_stride(0), offset + attribute.offset);
+    }
+}
+
+
+void Mesh::_render(unsigned int lod, unsigned int instances) const {
     if (_vao) {
-        glBindVertexArray(_vao);
-        glDrawElements(_renderMode, _numIndices, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        MeshLod range = get_lod(lod);
+        std::size_t offset = range.first * index_size(_indexType);
+        if (instances == 1) {
+            glDrawElements(_renderMode, range.count, _indexType, (void*)offset);
+        }
+        else {
+            glDrawElementsInstanced(_renderMode, range.count, _indexType, (void*)offset, instances);
+        }
     }
 }
 
@@ -0,0 +1,709 @@
+#include <jelly/gl/mesh_optimizer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <jelly/math/bounds.hpp>
+
+namespace {
+
+
+using namespace jelly;
+
+
+// The scoring of Forsyth's algorithm, which models a larger LRU cache than
+// the simulated FIFO one
+const unsigned int SCORE_CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+
+/**
+ * Throws if the indices are not a triangle list of vertexCount vertices.
+ */
+void check_triangles(const std::vector<unsigned int>& indices, unsigned int vertexCount) {
+    if (indices.size() % 3 != 0) {
+        throw std::runtime_error("Mesh optimization requires a triangle list");
+    }
+    for (unsigned int index : indices) {
+        if (index >= vertexCount) {
+            throw std::runtime_error("Mesh index out of range of the vertices");
+        }
+    }
+}
+
+
+/**
+ * A FIFO vertex cache, which tracks the time each vertex entered it.
+ */
+class FifoCache {
+
+public:
+
+    FifoCache(unsigned int vertexCount, unsigned int size) :
+        _times(vertexCount, 0),
+        _time(size + 1),
+        _size(size)
+    {}
+
+    /**
+     * Uses a vertex, returning true if it missed the cache.
+     */
+    bool access(unsigned int v)
+    {
+        if (_time - _times[v] <= _size) {
+            return false;
+        }
+        _times[v] = _time++;
+        return true;
+    }
+
+    /**
+     * Empties the cache.
+     */
+    void reset()
+    {
+        _time += _size + 1;
+    }
+
+private:
+
+    std::vector<unsigned int> _times;
+    unsigned int _time;
+    unsigned int _size;
+
+};
+
+
+float vertex_score(int cachePosition, unsigned int valence) {
+    if (valence == 0) {
+        // The vertex has no triangles left to add
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // The vertices of the last triangle score the same, so that the
+            // next triangle doesn't favor one of its edges
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else {
+            float scale = 1.0f / (SCORE_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Favor vertices with few triangles left, to finish them off
+    return score + VALENCE_BOOST_SCALE * std::pow((float)valence, -VALENCE_BOOST_POWER);
+}
+
+
+
+/**
+ * The weighted sum of squared distances to planes, as a symmetric matrix A,
+ * a vector b and a constant c, with the sum of the weights.
+ */
+struct Quadric {
+
+    Quadric() : a00(0), a01(0), a02(0), a11(0), a12(0), a22(0), b0(0), b1(0), b2(0), c(0), w(0) {}
+
+    /**
+     * Creates the quadric of the plane dot(n, p) + d = 0, with a unit n.
+     */
+    Quadric(const Vec3& n, float d, float weight) :
+        a00(weight * n.x() * n.x()), a01(weight * n.x() * n.y()), a02(weight * n.x() * n.z()),
+        a11(weight * n.y() * n.y()), a12(weight * n.y() * n.z()), a22(weight * n.z() * n.z()),
+        b0(weight * d * n.x()), b1(weight * d * n.y()), b2(weight * d * n.z()),
+        c(weight * (double)d * d), w(weight)
+    {}
+
+    void add(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02;
+        a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c;
+        w += q.w;
+    }
+
+    /**
+     * Returns the weighted sum of squared distances of p to the planes.
+     */
+    double evaluate(const Vec3& p) const
+    {
+        double x = p.x();
+        double y = p.y();
+        double z = p.z();
+        double e = a00*x*x + a11*y*y + a22*z*z + 2.0 * (a01*x*y + a02*x*z + a12*y*z)
+            + 2.0 * (b0*x + b1*y + b2*z) + c;
+        return e > 0.0 ? e : 0.0;
+    }
+
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double w;
+
+};
+
+
+/**
+ * A candidate collapse of vertex u onto vertex v.
+ */
+struct Collapse {
+    float cost;
+    unsigned int u;
+    unsigned int v;
+};
+
+
+/**
+ * Builds the list of the triangles of each vertex, in adjacency from
+ * offsets[v] to offsets[v + 1].
+ */
+void build_adjacency(const std::vector<unsigned int>& indices, unsigned int vertexCount,
+                     std::vector<unsigned int>& offsets, std::vector<unsigned int>& adjacency) {
+    offsets.assign(vertexCount + 1, 0);
+    for (unsigned int index : indices) {
+        offsets[index + 1] += 1;
+    }
+    for (unsigned int v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    adjacency.resize(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (unsigned int i = 0; i < indices.size(); ++i) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+}
+
+
+/**
+ * Returns true if moving u onto v flips or nearly degenerates one of the
+ * triangles of u which remain after the collapse.
+ */
+bool collapse_flips(const std::vector<unsigned int>& indices, const std::vector<Vec3>& positions,
+                    const unsigned int* triangles, unsigned int count, unsigned int u, unsigned int v) {
+    for (unsigned int i = 0; i < count; ++i) {
+        const unsigned int* tri = &indices[3 * triangles[i]];
+        if (tri[0] == v || tri[1] == v || tri[2] == v) {
+            continue;
+        }
+        // Rotate the triangle so that u comes first
+        unsigned int k = tri[0] == u ? 0 : (tri[1] == u ? 1 : 2);
+        const Vec3& b = positions[tri[(k + 1) % 3]];
+        const Vec3& c = positions[tri[(k + 2) % 3]];
+        Vec3 before = cross(b - positions[u], c - positions[u]);
+        Vec3 after = cross(b - positions[v], c - positions[v]);
+        if (dot(before, after) < 0.25f * magnitude(before) * magnitude(after)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * Simplifies a triangle list in steps, keeping the quadrics of the vertices
+ * between them.
+ */
+class Simplifier {
+
+public:
+
+    Simplifier(const std::vector<unsigned int>& indices, const std::vector<Vec3>& positions);
+
+    /**
+     * Collapses edges until at most targetIndexCount indices remain, or no
+     * edge can collapse.
+     */
+    void reduce(unsigned int targetIndexCount);
+
+    const std::vector<unsigned int>& get_indices() const
+    {
+        return _indices;
+    }
+
+    /**
+     * Returns the approximate distance to the original triangles.
+     */
+    float get_error() const
+    {
+        return (float)std::sqrt(_error);
+    }
+
+private:
+
+    const std::vector<Vec3>& _positions;
+    std::vector<unsigned int> _indices;
+    std::vector<Quadric> _quadrics;
+    std::vector<bool> _locked;
+    double _error;
+
+};
+
+
+Simplifier::Simplifier(const std::vector<unsigned int>& indices, const std::vector<Vec3>& positions) :
+    _positions(positions),
+    _indices(indices),
+    _quadrics(positions.size()),
+    _locked(positions.size(), false),
+    _error(0.0)
+{
+    // Sum the planes of the triangles of each vertex, weighted by area, and
+    // lock the vertices of edges with a single triangle
+    std::unordered_map<std::uint64_t, unsigned int> edges;
+    for (unsigned int t = 0; t < indices.size() / 3; ++t) {
+        const unsigned int* tri = &indices[3*t];
+        const Vec3& a = positions[tri[0]];
+        Vec3 n = cross(positions[tri[1]] - a, positions[tri[2]] - a);
+        float area = magnitude(n);
+        if (area > 0.0f) {
+            n = (1.0f / area) * n;
+            Quadric q(n, -dot(n, a), 0.5f * area);
+            for (unsigned int i = 0; i < 3; ++i) {
+                _quadrics[tri[i]].add(q);
+            }
+        }
+        for (unsigned int i = 0; i < 3; ++i) {
+            unsigned int p = tri[i];
+            unsigned int q = tri[(i + 1) % 3];
+            std::uint64_t key = (std::uint64_t)(p < q ? p : q) << 32 | (p < q ? q : p);
+            edges[key] += 1;
+        }
+    }
+    for (const auto& edge : edges) {
+        if (edge.second == 1) {
+            _locked[edge.first >> 32] = true;
+            _locked[edge.first & 0xffffffffu] = true;
+        }
+    }
+}
+
+
+void Simplifier::reduce(unsigned int targetIndexCount) {
+    // Collapse the cheapest edges in passes, each changing a vertex and its
+    // neighbors at most once
+    unsigned int vertexCount = _positions.size();
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+
+    while (_indices.size() > targetIndexCount) {
+        build_adjacency(_indices, vertexCount, offsets, adjacency);
+
+        collapses.clear();
+        for (unsigned int i = 0; i < _indices.size(); ++i) {
+            unsigned int u = _indices[i];
+            unsigned int v = _indices[i - i % 3 + (i + 1) % 3];
+            for (unsigned int k = 0; k < 2; ++k) {
+                if (!_locked[u] && u != v) {
+                    Quadric q = _quadrics[u];
+                    q.add(_quadrics[v]);
+                    float cost = q.w > 0.0 ? (float)(q.evaluate(_positions[v]) / q.w) : 0.0f;
+                    collapses.push_back({cost, u, v});
+                }
+                std::swap(u, v);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.cost < b.cost;
+        });
+
+        for (unsigned int v = 0; v < vertexCount; ++v) {
+            remap[v] = v;
+        }
+        touched.assign(vertexCount, false);
+        unsigned int triangleCount = _indices.size() / 3;
+        unsigned int collapsed = 0;
+
+        for (const Collapse& c : collapses) {
+            if (triangleCount * 3 <= targetIndexCount) {
+                break;
+            }
+            if (touched[c.u] || touched[c.v]) {
+                continue;
+            }
+            const unsigned int* triangles = &adjacency[offsets[c.u]];
+            unsigned int count = offsets[c.u + 1] - offsets[c.u];
+            if (collapse_flips(_indices, _positions, triangles, count, c.u, c.v)) {
+                continue;
+            }
+
+            remap[c.u] = c.v;
+            _quadrics[c.v].add(_quadrics[c.u]);
+            _error = c.cost > _error ? c.cost : _error;
+            for (unsigned int i = 0; i < count; ++i) {
+                const unsigned int* tri = &_indices[3 * triangles[i]];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+                if (tri[0] == c.v || tri[1] == c.v || tri[2] == c.v) {
+                    triangleCount -= 1;
+                }
+            }
+            collapsed += 1;
+        }
+        if (collapsed == 0) {
+            break;
+        }
+
+        // Remove the triangles which collapsed to an edge
+        unsigned int n = 0;
+        for (unsigned int i = 0; i < _indices.size(); i += 3) {
+            unsigned int a = remap[_indices[i]];
+            unsigned int b = remap[_indices[i + 1]];
+            unsigned int c = remap[_indices[i + 2]];
+            if (a != b && b != c && a != c) {
+                _indices[n++] = a;
+                _indices[n++] = b;
+                _indices[n++] = c;
+            }
+        }
+        _indices.resize(n);
+    }
+}
+
+
+}
+
+
+namespace jelly {
+
+
+VertexCacheStats MeshOptimizer::analyze_vertex_cache(
+    const std::vector<unsigned int>& indices,
+    unsigned int vertexCount,
+    unsigned int cacheSize
+) {
+    check_triangles(indices, vertexCount);
+
+    FifoCache cache(vertexCount, cacheSize);
+    unsigned int misses = 0;
+    for (unsigned int index : indices) {
+        misses += cache.access(index) ? 1 : 0;
+    }
+
+    VertexCacheStats stats = {0.0f, 0.0f};
+    if (!indices.empty()) {
+        stats.acmr = misses / (indices.size() / 3.0f);
+        stats.atvr = misses / (float)vertexCount;
+    }
+    return stats;
+}
+
+
+void MeshOptimizer::optimize_vertex_cache(std::vector<unsigned int>& indices, unsigned int vertexCount) {
+    check_triangles(indices, vertexCount);
+    unsigned int triangleCount = indices.size() / 3;
+
+    // List the triangles of each vertex, removing them as they are added
+    std::vector<unsigned int> valences(vertexCount, 0);
+    for (unsigned int index : indices) {
+        valences[index] += 1;
+    }
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] = offsets[v] + valences[v];
+    }
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (unsigned int i = 0; i < indices.size(); ++i) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; ++v) {
+        vertexScores[v] = vertex_score(-1, valences[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> added(triangleCount, false);
+    int best = -1;
+    float bestScore = -1.0f;
+    for (unsigned int t = 0; t < triangleCount; ++t) {
+        const unsigned int* tri = &indices[3*t];
+        triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+        if (triangleScores[t] > bestScore) {
+            best = t;
+            bestScore = triangleScores[t];
+        }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> nextCache;
+    unsigned int cursor = 0;
+
+    for (unsigned int k = 0; k < triangleCount; ++k) {
+        if (best < 0) {
+            // None of the cached vertices have triangles left, continue with
+            // the next triangle in input order
+            while (added[cursor]) {
+                ++cursor;
+            }
+            best = cursor;
+        }
+
+        const unsigned int* tri = &indices[3*best];
+        added[best] = true;
+        result.insert(result.end(), tri, tri + 3);
+
+        for (unsigned int i = 0; i < 3; ++i) {
+            unsigned int v = tri[i];
+            unsigned int* triangles = &adjacency[offsets[v]];
+            unsigned int* end = triangles + valences[v];
+            *std::find(triangles, end, (unsigned int)best) = *(end - 1);
+            valences[v] -= 1;
+        }
+
+        // Move the triangle's vertices to the front of the cache
+        nextCache.clear();
+        for (unsigned int i = 0; i < 3; ++i) {
+            if (std::find(nextCache.begin(), nextCache.end(), tri[i]) == nextCache.end()) {
+                nextCache.push_back(tri[i]);
+            }
+        }
+        for (unsigned int v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                nextCache.push_back(v);
+            }
+        }
+
+        // Rescore the cached and evicted vertices and their triangles, and
+        // pick the best triangle among them
+        for (unsigned int i = 0; i < nextCache.size(); ++i) {
+            unsigned int v = nextCache[i];
+            cachePositions[v] = i < SCORE_CACHE_SIZE ? (int)i : -1;
+            vertexScores[v] = vertex_score(cachePositions[v], valences[v]);
+        }
+        best = -1;
+        bestScore = -1.0f;
+        for (unsigned int v : nextCache) {
+            for (unsigned int j = offsets[v]; j < offsets[v] + valences[v]; ++j) {
+                unsigned int t = adjacency[j];
+                const unsigned int* other = &indices[3*t];
+                triangleScores[t] = vertexScores[other[0]] + vertexScores[other[1]] + vertexScores[other[2]];
+                if (cachePositions[v] >= 0 && triangleScores[t] > bestScore) {
+                    best = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+        }
+
+        if (nextCache.size() > SCORE_CACHE_SIZE) {
+            nextCache.resize(SCORE_CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+    }
+
+    indices.swap(result);
+}
+
+
+void MeshOptimizer::optimize_overdraw(
+    std::vector<unsigned int>& indices,
+    const std::vector<Vec3>& positions,
+    float threshold
+) {
+    check_triangles(indices, positions.size());
+    unsigned int triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+    float acmr = analyze_vertex_cache(indices, positions.size()).acmr;
+
+    // Split the triangles into clusters where the cache was flushed, and
+    // where a cluster has reached nearly the mesh's ACMR on its own, since
+    // the clusters may be drawn in any order
+    std::vector<unsigned int> clusters;
+    FifoCache cache(positions.size(), CACHE_SIZE);
+    unsigned int clusterTriangles = 0;
+    unsigned int clusterMisses = 0;
+    for (unsigned int t = 0; t < triangleCount; ++t) {
+        unsigned int misses = 0;
+        for (unsigned int i = 0; i < 3; ++i) {
+            misses += cache.access(indices[3*t + i]) ? 1 : 0;
+        }
+        if (t == 0 || (misses == 3 && clusterTriangles > 0)) {
+            clusters.push_back(t);
+            clusterTriangles = 0;
+            clusterMisses = 0;
+        }
+        clusterTriangles += 1;
+        clusterMisses += misses;
+
+        if (clusterMisses <= threshold * acmr * clusterTriangles && t + 1 < triangleCount) {
+            clusters.push_back(t + 1);
+            clusterTriangles = 0;
+            clusterMisses = 0;
+            cache.reset();
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Sort the clusters by how far out they face from the mesh's center,
+    // with the area-weighted centroids and normals
+    unsigned int clusterCount = clusters.size() - 1;
+    std::vector<Vec3> centroids(clusterCount);
+    std::vector<Vec3> normals(clusterCount);
+    Vec3 center;
+    float area = 0.0f;
+    for (unsigned int c = 0; c < clusterCount; ++c) {
+        float clusterArea = 0.0f;
+        for (unsigned int t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const Vec3& a = positions[indices[3*t]];
+            const Vec3& b = positions[indices[3*t + 1]];
+            const Vec3& d = positions[indices[3*t + 2]];
+            Vec3 n = cross(b - a, d - a);
+            float triangleArea = magnitude(n);
+            centroids[c] = centroids[c] + (triangleArea / 3.0f) * (a + b + d);
+            normals[c] = normals[c] + n;
+            clusterArea += triangleArea;
+        }
+        center = center + centroids[c];
+        area += clusterArea;
+        if (clusterArea > 0.0f) {
+            centroids[c] = (1.0f / clusterArea) * centroids[c];
+        }
+    }
+    if (area > 0.0f) {
+        center = (1.0f / area) * center;
+    }
+
+    std::vector<float> keys(clusterCount);
+    std::vector<unsigned int> order(clusterCount);
+    for (unsigned int c = 0; c < clusterCount; ++c) {
+        float length = magnitude(normals[c]);
+        keys[c] = length > 0.0f ? dot(centroids[c] - center, normals[c]) / length : 0.0f;
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&keys](unsigned int a, unsigned int b) {
+        return keys[a] > keys[b];
+    });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (unsigned int c : order) {
+        result.insert(result.end(), indices.begin() + 3*clusters[c], indices.begin() + 3*clusters[c + 1]);
+    }
+    indices.swap(result);
+}
+
+
+std::vector<unsigned int> MeshOptimizer::optimize_vertex_fetch(
+    std::vector<unsigned int>& indices,
+    unsigned int vertexCount
+) {
+    check_triangles(indices, vertexCount);
+
+    const unsigned int UNUSED = ~0u;
+    std::vector<unsigned int> remap(vertexCount, UNUSED);
+    unsigned int next = 0;
+    for (unsigned int& index : indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+    for (unsigned int& r : remap) {
+        if (r == UNUSED) {
+            r = next++;
+        }
+    }
+    return remap;
+}
+
+
+std::vector<unsigned int> MeshOptimizer::simplify(
+    const std::vector<unsigned int>& indices,
+    const std::vector<Vec3>& positions,
+    unsigned int targetIndexCount,
+    float* error
+) {
+    check_triangles(indices, positions.size());
+    Simplifier simplifier(indices, positions);
+    simplifier.reduce(targetIndexCount);
+    if (error) {
+        *error = simplifier.get_error();
+    }
+    return simplifier.get_indices();
+}
+
+
+std::vector<MeshLod> MeshOptimizer::generate_lods(
+    std::vector<unsigned int>& indices,
+    const std::vector<Vec3>& positions,
+    unsigned int levels,
+    float ratio
+) {
+    check_triangles(indices, positions.size());
+    std::vector<MeshLod> lods;
+    lods.push_back({0, (unsigned int)indices.size(), 0.0f});
+
+    // Levels which lose the shape of the mesh are useless, so the error is
+    // limited relative to its size
+    Aabb bounds;
+    for (const Vec3& p : positions) {
+        bounds.expand(p);
+    }
+    float maxError = bounds.is_empty() ? 0.0f : 0.1f * magnitude(bounds.extent());
+
+    // Keep simplifying the previous level, whose quadrics still measure the
+    // error to the full mesh
+    Simplifier simplifier(indices, positions);
+    float target = indices.size();
+    for (unsigned int level = 1; level < levels; ++level) {
+        target *= ratio;
+        simplifier.reduce((unsigned int)target / 3 * 3);
+        std::vector<unsigned int> lod = simplifier.get_indices();
+
+        // Stop once the levels barely shrink, e.g. at the locked borders
+        if (lod.empty() || lod.size() > 0.9f * lods.back().count || simplifier.get_error() > maxError) {
+            break;
+        }
+        optimize_vertex_cache(lod, positions.size());
+        lods.push_back({(unsigned int)indices.size(), (unsigned int)lod.size(), simplifier.get_error()});
+        indices.insert(indices.end(), lod.begin(), lod.end());
+    }
+    return lods;
+}
+
+
+void MeshOptimizer::optimize(
+    std::vector<Vec3>& vertices,
+    std::vector<Vec3>& normals,
+    std::vector<Vec2>& uvs,
+    std::vector<unsigned int>& indices,
+    Report* report
+) {
+    if (normals.size() != vertices.size() || uvs.size() != vertices.size()) {
+        throw std::runtime_error("Vertex attributes differ in length");
+    }
+    unsigned int vertexCount = vertices.size();
+    if (report) {
+        report->before = analyze_vertex_cache(indices, vertexCount);
+    }
+
+    optimize_vertex_cache(indices, vertexCount);
+    optimize_overdraw(indices, vertices);
+    std::vector<unsigned int> remap = optimize_vertex_fetch(indices, vertexCount);
+    remap_vertices(vertices, remap);
+    remap_vertices(normals, remap);
+    remap_vertices(uvs, remap);
+
+    if (report) {
+        report->after = analyze_vertex_cache(indices, vertexCount);
+    }
+}
+
+
+}
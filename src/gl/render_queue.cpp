@@ -0,0 +1,238 @@
+#include <jelly/gl/render_queue.hpp>
+
+#include <cstring>
+
+#include <GL/glew.h>
+
+#include <jelly/gl/context.hpp>
+#include <jelly/gl/texture.hpp>
+
+namespace {
+
+
+/**
+ * Maps a float to an unsigned integer with the same ordering.
+ */
+std::uint32_t sortable_float(float f) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+
+}
+
+
+namespace jelly {
+
+
+RenderQueue::RenderQueue() :
+    _shaderSwitches(0)
+{}
+
+
+RenderQueue::Draw RenderQueue::draw(
+    Shader& shader,
+    const Mesh& mesh,
+    unsigned int layer,
+    float depth,
+    Pass pass
+) {
+    Packet packet = {
+        &shader,
+        &mesh,
+        (unsigned int)_uniforms.size(),
+        0,
+        layer < 255 ? layer : 255,
+        (unsigned int)pass,
+        depth,
+        0
+    };
+    _packets.push_back(packet);
+    return Draw(this);
+}
+
+
+void RenderQueue::submit(Context& c) {
+    _sort();
+
+    _shaderSwitches = 0;
+    Shader* current = nullptr;
+    for (unsigned int i : _order) {
+        const Packet& packet = _packets[i];
+        if (packet.shader != current) {
+            c.activate_shader(*packet.shader);
+            current = packet.shader;
+            _shaderSwitches += 1;
+        }
+
+        // The shader skips values that did not change since the last draw
+        Shader& s = *packet.shader;
+        for (unsigned int j = 0; j < packet.numUniforms; ++j) {
+            UniformValue& u = _uniforms[packet.firstUniform + j];
+            switch (u.type) {
+                case GL_INT: {
+                    int value;
+                    std::memcpy(&value, u.data, sizeof(value));
+                    s.set_uniform_int(u.location, value);
+                    break;
+                }
+                case GL_FLOAT:
+                    s.set_uniform_float(u.location, u.data[0]);
+                    break;
+                case GL_FLOAT_VEC2:
+                    s.set_uniform_vec2(u.location, Vec2(u.data[0], u.data[1]));
+                    break;
+                case GL_FLOAT_VEC3:
+                    s.set_uniform_vec3(u.location, Vec3(u.data[0], u.data[1], u.data[2]));
+                    break;
+                case GL_FLOAT_VEC4:
+                    s.set_uniform_vec4(u.location, Vec4(u.data[0], u.data[1], u.data[2], u.data[3]));
+                    break;
+                case GL_FLOAT_MAT3:
+                    s.set_uniform_mat3(u.location, Mat3(u.data));
+                    break;
+                case GL_FLOAT_MAT4:
+                    s.set_uniform_mat4(u.location, Mat4(u.data));
+                    break;
+                case GL_SAMPLER_2D:
+                    s.set_uniform_sampler(u.location, *u.texture);
+                    break;
+            }
+        }
+
+        c.render_mesh(*packet.mesh, packet.lod);
+    }
+
+    clear();
+}
+
+
+void RenderQueue::clear() {
+    _packets.clear();
+    _uniforms.clear();
+}
+
+
+void RenderQueue::_add_uniform(int location, int value) {
+    UniformValue& u = _push_uniform(location, GL_INT);
+    std::memcpy(u.data, &value, sizeof(value));
+}
+
+
+void RenderQueue::_add_uniform(int location, float value) {
+    _push_uniform(location, GL_FLOAT).data[0] = value;
+}
+
+
+void RenderQueue::_add_uniform(int location, const Vec2& value) {
+    std::memcpy(_push_uniform(location, GL_FLOAT_VEC2).data, value.data(), 2 * sizeof(float));
+}
+
+
+void RenderQueue::_add_uniform(int location, const Vec3& value) {
+    std::memcpy(_push_uniform(location, GL_FLOAT_VEC3).data, value.data(), 3 * sizeof(float));
+}
+
+
+void RenderQueue::_add_uniform(int location, const Vec4& value) {
+    std::memcpy(_push_uniform(location, GL_FLOAT_VEC4).data, value.data(), 4 * sizeof(float));
+}
+
+
+void RenderQueue::_add_uniform(int location, const Mat3& value) {
+    std::memcpy(_push_uniform(location, GL_FLOAT_MAT3).data, value.data(), 9 * sizeof(float));
+}
+
+
+void RenderQueue::_add_uniform(int location, const Mat4& value) {
+    std::memcpy(_push_uniform(location, GL_FLOAT_MAT4).data, value.data(), 16 * sizeof(float));
+}
+
+
+void RenderQueue::_add_uniform(int location, const Texture& value) {
+    _push_uniform(location, GL_SAMPLER_2D).texture = &value;
+}
+
+
+RenderQueue::UniformValue& RenderQueue::_push_uniform(int location, unsigned int type) {
+    // Values of invalid handles are still recorded and ignored by the shader
+    UniformValue u;
+    u.location = location;
+    u.type = type;
+    u.texture = nullptr;
+    _uniforms.push_back(u);
+    _packets.back().numUniforms += 1;
+    return _uniforms.back();
+}
+
+
+std::uint64_t RenderQueue::_sort_key(const Packet& packet) const {
+    // | layer:8 | pass:1 | ...
+    std::uint64_t key = (std::uint64_t)packet.layer << 56;
+    key |= (std::uint64_t)packet.pass << 55;
+
+    std::uint32_t depth = sortable_float(packet.depth);
+    if (packet.pass == (unsigned int)Pass::TRANSLUCENT) {
+        // ... | far to near:32 | 0:23 |, where equal keys keep their order
+        return key | ((std::uint64_t)~depth << 23);
+    }
+
+    // ... | program:12 | texture:12 | mesh:12 | near to far:19 |, where GL
+    // names are truncated as collisions only cost extra state changes
+    unsigned int texture = 0;
+    for (unsigned int j = 0; j < packet.numUniforms; ++j) {
+        const UniformValue& u = _uniforms[packet.firstUniform + j];
+        if (u.texture) {
+            texture = u.texture->get_gl_handle();
+            break;
+        }
+    }
+    key |= (std::uint64_t)(packet.shader->get_gl_handle() & 0xFFF) << 43;
+    key |= (std::uint64_t)(texture & 0xFFF) << 31;
+    key |= (std::uint64_t)(packet.mesh->get_vbo_handle() & 0xFFF) << 19;
+    key |= depth >> 13;
+    return key;
+}
+
+
+void RenderQueue::_sort() {
+    unsigned int count = _packets.size();
+    _keys.resize(count);
+    _order.resize(count);
+    _keysTemp.resize(count);
+    _orderTemp.resize(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        _keys[i] = _sort_key(_packets[i]);
+        _order[i] = i;
+    }
+
+    // One pass per byte, skipping bytes that are equal for all keys such as
+    // unused layers
+    for (unsigned int shift = 0; shift < 64; shift += 8) {
+        unsigned int offsets[256] = {};
+        for (std::uint64_t key : _keys) {
+            offsets[(key >> shift) & 0xFF] += 1;
+        }
+        if (count == 0 || offsets[(_keys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        unsigned int total = 0;
+        for (unsigned int& offset : offsets) {
+            unsigned int n = offset;
+            offset = total;
+            total += n;
+        }
+        for (unsigned int i = 0; i < count; ++i) {
+            unsigned int dst = offsets[(_keys[i] >> shift) & 0xFF]++;
+            _keysTemp[dst] = _keys[i];
+            _orderTemp[dst] = _order[i];
+        }
+        _keys.swap(_keysTemp);
+        _order.swap(_orderTemp);
+    }
+}
+
+
+}
@@ -1,5 +1,8 @@
 #include <jelly/gl/shader.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -8,12 +11,15 @@
 #include <GL/glew.h>
 
 #include <jelly/gl/context.hpp>
+#include <jelly/gl/shader_cache.hpp>
 
 namespace {
 
 
 /**
- * Compiles the given GLSL code as the specified type of shader.
+ * Submits the given GLSL code for compilation as the specified type of shader.
+ * The compilation status is not queried, allowing the driver to compile in
+ * the background.
  *
  * \param glsl
  *     Shader source code.
@@ -21,17 +27,23 @@ namespace {
  *     The shader type constant.
  *
  * \return
- *     A handle to the compiled shader.
- *
- * \throws
- *     std::runtime_error if compilation failed.
+ *     A handle to the shader.
  */
 unsigned int compile_shader(const char* glsl, unsigned int type) {
     GLuint shader = glCreateShader(type);
-    // compile the shader
     glShaderSource(shader, 1, &glsl, nullptr);
     glCompileShader(shader);
-    // check the results
+    return shader;
+}
+
+
+/**
+ * Checks the compilation status of a shader, printing the log if it failed.
+ *
+ * \return
+ *     True if the shader compiled successfully.
+ */
+bool check_shader(unsigned int shader) {
     GLint result = GL_FALSE;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE) {
@@ -40,42 +52,62 @@ unsigned int compile_shader(const char* glsl, unsigned int type) {
         std::cerr << "==============================" << std::endl;
         std::cerr << "GLSL Shader compilation failed" << std::endl << log;
         std::cerr << "==============================" << std::endl;
-        glDeleteShader(shader);
-        throw std::runtime_error("failed to compile shader");
+        return false;
     }
-    return shader;
+    return true;
 }
 
 
 /**
- * Links the vertex and fragment shaders.
+ * Submits the vertex and fragment shaders for linking. The link status is not
+ * queried, allowing the driver to link in the background.
  *
  * \param v
- *     A handle to the compiled vertex shader.
+ *     A handle to the vertex shader.
  * \param f
- *     A handle to the compiled fragment shader.
+ *     A handle to the fragment shader.
+ * \param retrievable
+ *     If true, hints the driver that the program binary will be retrieved.
  *
  * \return
- *     A handle to the linked shader program.
- *
- * \throws
- *     std::runtime_error if linking failed.
+ *     A handle to the shader program.
  */
-unsigned int link_program(unsigned int vert, unsigned int frag) {
+unsigned int link_program(unsigned int vert, unsigned int frag, bool retrievable) {
     GLuint program = glCreateProgram();
-    // link the program and get the result
+    if (retrievable) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glAttachShader(program, vert);
     glAttachShader(program, frag);
     glLinkProgram(program);
+    return program;
+}
+
+
+/**
+ * Waits for the program to link and checks the result. The shaders are
+ * deleted, and the program as well if linking failed.
+ *
+ * \throws
+ *     std::runtime_error if compilation or linking failed.
+ */
+void check_program(unsigned int program, unsigned int vert, unsigned int frag) {
     GLint result = GL_FALSE;
     glGetProgramiv(program, GL_LINK_STATUS, &result);
 
+    // report compilation errors first as they are the likely cause
+    bool compiled = result == GL_TRUE || (check_shader(vert) & check_shader(frag));
+
     // clean up the shaders before possibly throwing an exception
     glDetachShader(program, vert);
     glDetachShader(program, frag);
     glDeleteShader(vert);
     glDeleteShader(frag);
 
+    if (!compiled) {
+        glDeleteProgram(program);
+        throw std::runtime_error("failed to compile shader");
+    }
     if (result == GL_FALSE) {
         char log[512] = {};
         glGetProgramInfoLog(program, 512, NULL, log);
@@ -85,7 +117,107 @@ unsigned int link_program(unsigned int vert, unsigned int frag) {
         glDeleteProgram(program);
         throw std::runtime_error("failed to link vertex and fragment shaders");
     }
-    return program;
+}
+
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+/**
+ * Returns true if the uniform type is a sampler.
+ */
+bool is_sampler_type(unsigned int type) {
+    switch (type) {
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_SHADOW:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_1D_ARRAY:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_1D_ARRAY_SHADOW:
+        case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_2D_MULTISAMPLE:
+        case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_SAMPLER_CUBE_SHADOW:
+        case GL_SAMPLER_BUFFER:
+        case GL_SAMPLER_2D_RECT:
+        case GL_SAMPLER_2D_RECT_SHADOW:
+        case GL_INT_SAMPLER_1D:
+        case GL_INT_SAMPLER_2D:
+        case GL_INT_SAMPLER_3D:
+        case GL_INT_SAMPLER_CUBE:
+        case GL_INT_SAMPLER_1D_ARRAY:
+        case GL_INT_SAMPLER_2D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_1D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_3D:
+        case GL_UNSIGNED_INT_SAMPLER_CUBE:
+        case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * Returns the number of scalar components of a uniform type, or 0 if the type
+ * is not supported.
+ */
+unsigned int uniform_components(unsigned int type) {
+    switch (type) {
+        case GL_FLOAT:
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+        case GL_BOOL:
+            return 1;
+        case GL_FLOAT_VEC2:
+        case GL_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC2:
+        case GL_BOOL_VEC2:
+            return 2;
+        case GL_FLOAT_VEC3:
+        case GL_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC3:
+        case GL_BOOL_VEC3:
+            return 3;
+        case GL_FLOAT_VEC4:
+        case GL_INT_VEC4:
+        case GL_UNSIGNED_INT_VEC4:
+        case GL_BOOL_VEC4:
+        case GL_FLOAT_MAT2:
+            return 4;
+        case GL_FLOAT_MAT3:
+            return 9;
+        case GL_FLOAT_MAT4:
+            return 16;
+        default:
+            return is_sampler_type(type) ? 1 : 0;
+    }
+}
+
+
+/**
+ * Returns true if the uniform type holds integer rather than float values.
+ */
+bool is_integer_type(unsigned int type) {
+    switch (type) {
+        case GL_FLOAT:
+        case GL_FLOAT_VEC2:
+        case GL_FLOAT_VEC3:
+        case GL_FLOAT_VEC4:
+        case GL_FLOAT_MAT2:
+        case GL_FLOAT_MAT3:
+        case GL_FLOAT_MAT4:
+            return false;
+        default:
+            return true;
+    }
 }
 
 
@@ -95,34 +227,108 @@ unsigned int link_program(unsigned int vert, unsigned int frag) {
 namespace jelly {
 
 
-Shader::Shader(const std::string& vs, const std::string& fs) {
+Shader::Shader(const std::string& vs, const std::string& fs, Compilation mode) :
+    _vertexShaderHandle(0),
+    _fragmentShaderHandle(0),
+    _pending(false),
+    _compileSeconds(0.0),
+    _activeContext(nullptr)
+{
+    _programHandle = ShaderCache::_load(vs, fs);
+    if (_programHandle) {
+        _reflect_uniforms();
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool cached = ShaderCache::is_enabled();
     _vertexShaderHandle = compile_shader(vs.c_str(), GL_VERTEX_SHADER);
     _fragmentShaderHandle = compile_shader(fs.c_str(), GL_FRAGMENT_SHADER);
-    _programHandle = link_program(_vertexShaderHandle, _fragmentShaderHandle);
+    _programHandle = link_program(_vertexShaderHandle, _fragmentShaderHandle, cached);
+    _compileSeconds = seconds_since(start);
+    _pending = true;
 
-    _activeContext = nullptr;
+    if (cached) {
+        _vertexSource = vs;
+        _fragmentSource = fs;
+    }
+    if (mode == Compilation::IMMEDIATE) {
+        _finalize();
+    }
 }
 
 
 Shader::~Shader() {
+    if (_pending) {
+        glDeleteShader(_vertexShaderHandle);
+        glDeleteShader(_fragmentShaderHandle);
+    }
     if (_programHandle) {
         glDeleteProgram(_programHandle);
     }
+    Context::_notify_deleted_shader(this);
+}
+
+
+bool Shader::is_ready() const {
+    if (!_pending) {
+        return true;
+    }
+    if (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile) {
+        GLint done = GL_FALSE;
+        glGetProgramiv(_programHandle, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+    // Without the extension there is no way to query without blocking
+    return false;
+}
+
+
+void Shader::wait() {
+    _finalize();
+}
+
+
+bool Shader::has_uniform(const std::string& u) {
+    _finalize();
+    auto it = _uniformNameMap.find(u);
+    return it != _uniformNameMap.end() && (int)it->second >= 0;
+}
+
+
+bool Shader::has_uniform(UniformName u) {
+    _finalize();
+    return _find_uniform(u) >= 0;
 }
 
 
 unsigned int Shader::get_uniform_handle(const std::string& u) {
-    try {
-        return _uniformNameMap.at(u);
-    } catch (...) {
-        // not cached yet, find it
-        int h = glGetUniformLocation(_programHandle, u.c_str());
-        if (h < 0) {
-            std::cerr << "Warning: uniform " << u << " not found" << std::endl;
-        }
-        _uniformNameMap[u] = h;
-        return h;
+    _finalize();
+    auto it = _uniformNameMap.find(u);
+    if (it != _uniformNameMap.end()) {
+        return it->second;
     }
+
+    // All active uniforms are known after linking, so remember the miss to
+    // only warn once
+    std::cerr << "Warning: uniform " << u << " not found" << std::endl;
+    _uniformNameMap[u] = -1;
+    return -1;
+}
+
+
+unsigned int Shader::get_uniform_handle(UniformName u) {
+    _finalize();
+    int location = _find_uniform(u);
+    if (location >= 0) {
+        return location;
+    }
+
+    if (std::find(_unknownUniformHashes.begin(), _unknownUniformHashes.end(), u.hash()) == _unknownUniformHashes.end()) {
+        std::cerr << "Warning: uniform " << u.str() << " not found" << std::endl;
+        _unknownUniformHashes.push_back(u.hash());
+    }
+    return -1;
 }
 
 
@@ -131,11 +337,13 @@ void Shader::set_uniform_int(const std::string& u, int i) {
 }
 
 
+void Shader::set_uniform_int(UniformName u, int i) {
+    set_uniform_int(get_uniform_handle(u), i);
+}
+
+
 void Shader::set_uniform_int(unsigned int u, int i) {
-    _intUniformCache[u] = i;
-    if (is_active()) {
-        glUniform1i(u, i);
-    }
+    _store_uniform(u, &i, 1, true);
 }
 
 
@@ -144,11 +352,13 @@ void Shader::set_uniform_float(const std::string& u, float f) {
 }
 
 
+void Shader::set_uniform_float(UniformName u, float f) {
+    set_uniform_float(get_uniform_handle(u), f);
+}
+
+
 void Shader::set_uniform_float(unsigned int u, float f) {
-    _floatUniformCache[u] = f;
-    if (is_active()) {
-        glUniform1f(u, f);
-    }
+    _store_uniform(u, &f, 1, false);
 }
 
 
@@ -157,11 +367,13 @@ void Shader::set_uniform_vec2(const std::string& u, const Vec2& v) {
 }
 
 
+void Shader::set_uniform_vec2(UniformName u, const Vec2& v) {
+    set_uniform_vec2(get_uniform_handle(u), v);
+}
+
+
 void Shader::set_uniform_vec2(unsigned int u, const Vec2& v) {
-    _vec2UniformCache[u] = v;
-    if (is_active()) {
-        glUniform2fv(u, 1, v.data());
-    }
+    _store_uniform(u, v.data(), 2, false);
 }
 
 
@@ -170,11 +382,13 @@ void Shader::set_uniform_vec3(const std::string& u, const Vec3& v) {
 }
 
 
+void Shader::set_uniform_vec3(UniformName u, const Vec3& v) {
+    set_uniform_vec3(get_uniform_handle(u), v);
+}
+
+
 void Shader::set_uniform_vec3(unsigned int u, const Vec3& v) {
-    _vec3UniformCache[u] = v;
-    if (is_active()) {
-        glUniform3fv(u, 1, v.data());
-    }
+    _store_uniform(u, v.data(), 3, false);
 }
 
 
@@ -183,11 +397,13 @@ void Shader::set_uniform_vec4(const std::string& u, const Vec4& v) {
 }
 
 
+void Shader::set_uniform_vec4(UniformName u, const Vec4& v) {
+    set_uniform_vec4(get_uniform_handle(u), v);
+}
+
+
 void Shader::set_uniform_vec4(unsigned int u, const Vec4& v) {
-    _vec4UniformCache[u] = v;
-    if (is_active()) {
-        glUniform4fv(u, 1, v.data());
-    }
+    _store_uniform(u, v.data(), 4, false);
 }
 
 
@@ -196,11 +412,13 @@ void Shader::set_uniform_mat3(const std::string& u, const Mat3& m) {
 }
 
 
+void Shader::set_uniform_mat3(UniformName u, const Mat3& m) {
+    set_uniform_mat3(get_uniform_handle(u), m);
+}
+
+
 void Shader::set_uniform_mat3(unsigned int u, const Mat3& m) {
-    _mat3UniformCache[u] = m;
-    if (is_active()) {
-        glUniformMatrix3fv(u, 1, GL_FALSE, m.data());
-    }
+    _store_uniform(u, m.data(), 9, false);
 }
 
 
@@ -209,11 +427,13 @@ void Shader::set_uniform_mat4(const std::string& u, const Mat4& m) {
 }
 
 
+void Shader::set_uniform_mat4(UniformName u, const Mat4& m) {
+    set_uniform_mat4(get_uniform_handle(u), m);
+}
+
+
 void Shader::set_uniform_mat4(unsigned int u, const Mat4& m) {
-    _mat4UniformCache[u] = m;
-    if (is_active()) {
-        glUniformMatrix4fv(u, 1, GL_FALSE, m.data());
-    }
+    _store_uniform(u, m.data(), 16, false);
 }
 
 
@@ -222,62 +442,278 @@ void Shader::set_uniform_sampler(const std::string& u, const Texture& tex) {
 }
 
 
+void Shader::set_uniform_sampler(UniformName u, const Texture& tex) {
+    set_uniform_sampler(get_uniform_handle(u), tex);
+}
+
+
 void Shader::set_uniform_sampler(unsigned int u, const Texture& tex) {
-    _samplerUniformCache[u] = &tex;
+    _finalize();
+    if (u >= _uniformSlotsByLocation.size() || _uniformSlotsByLocation[u] < 0) {
+        return;
+    }
+    const UniformSlot& slot = _uniforms[_uniformSlotsByLocation[u]];
+    if (slot.sampler < 0) {
+        std::cerr << "Warning: uniform at location " << u << " is not a sampler" << std::endl;
+        return;
+    }
 
+    // Texture units are fixed per sampler when the program is linked
+    _samplerTextures[slot.sampler] = &tex;
     if (is_active()) {
-        unsigned int bindIndex;
-        try {
-            bindIndex = _samplerBindingLocations.at(u);
-        } catch (...) {
-            bindIndex = _samplerUniformCache.size() - 1;
-            _samplerBindingLocations[u] = bindIndex;
-        }
-        _activeContext->bind_texture(tex, bindIndex);
-        glUniform1i(u, bindIndex);
+        _activeContext->bind_texture(tex, slot.sampler);
     }
 }
 
 
+bool Shader::set_uniform_block(const std::string& block, unsigned int binding) {
+    _finalize();
+    unsigned int index = glGetUniformBlockIndex(_programHandle, block.c_str());
+    if (index == GL_INVALID_INDEX) {
+        std::cerr << "Warning: uniform block " << block << " not found" << std::endl;
+        return false;
+    }
+    glUniformBlockBinding(_programHandle, index, binding);
+    return true;
+}
+
+
 void Shader::_activate(Context* c) {
-    glUseProgram(_programHandle);
+    _finalize();
     _activeContext = c;
 
-    // Apply the shader uniforms
-    for (auto& pair : _intUniformCache) {
-        glUniform1i(pair.first, pair.second);
+    // The program keeps its uniform values while inactive, so only the values
+    // changed since the last activation have to be uploaded
+    for (unsigned int i : _dirtyUniforms) {
+        UniformSlot& slot = _uniforms[i];
+        _upload_uniform(slot);
+        slot.dirty = false;
+    }
+    _dirtyUniforms.clear();
+
+    // Texture units are shared between programs, the context skips the units
+    // that still hold the right texture
+    for (unsigned int i = 0; i < _samplerTextures.size(); ++i) {
+        if (_samplerTextures[i]) {
+            c->bind_texture(*_samplerTextures[i], i);
+        }
+    }
+}
+
+
+void Shader::_deactivate() {
+    _activeContext = nullptr;
+}
+
+
+void Shader::_finalize() {
+    if (!_pending) {
+        return;
+    }
+    _pending = false;
+
+    // Blocks until the driver is done, the program is released while checking
+    // as it is deleted if compilation failed
+    auto start = std::chrono::steady_clock::now();
+    unsigned int program = _programHandle;
+    _programHandle = 0;
+    check_program(program, _vertexShaderHandle, _fragmentShaderHandle);
+    _programHandle = program;
+    _vertexShaderHandle = 0;
+    _fragmentShaderHandle = 0;
+    _compileSeconds += seconds_since(start);
+
+    ShaderCache::_store(_programHandle, _vertexSource, _fragmentSource, _compileSeconds);
+    _vertexSource.clear();
+    _fragmentSource.clear();
+
+    _reflect_uniforms();
+}
+
+
+void Shader::_reflect_uniforms() {
+    GLint count = 0, maxNameLength = 0;
+    glGetProgramiv(_programHandle, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(_programHandle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> nameBuffer(maxNameLength + 1);
+    unsigned int numSamplers = 0;
+    unsigned int dataSize = 0;
+
+    for (GLint i = 0; i < count; ++i) {
+        GLint arraySize = 0;
+        GLenum type = 0;
+        glGetActiveUniform(
+            _programHandle,
+            i,
+            nameBuffer.size(),
+            nullptr,
+            &arraySize,
+            &type,
+            nameBuffer.data()
+        );
+
+        unsigned int components = uniform_components(type);
+        if (components == 0) {
+            std::cerr << "Warning: uniform " << nameBuffer.data() << " has an unsupported type" << std::endl;
+            continue;
+        }
+
+        // Arrays are reported as "name[0]" and get a slot per element. Other
+        // brackets, e.g. of arrays of structs as "lights[0].pos", are part of
+        // the name
+        std::string name(nameBuffer.data());
+        bool array = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+        std::string baseName = array ? name.substr(0, name.size() - 3) : name;
+
+        for (GLint e = 0; e < arraySize; ++e) {
+            std::string elementName = array
+                ? baseName + "[" + std::to_string(e) + "]"
+                : baseName;
+            GLint location = glGetUniformLocation(_programHandle, elementName.c_str());
+            if (location < 0) {
+                // Uniforms in uniform blocks have no location
+                continue;
+            }
+
+            UniformSlot slot;
+            slot.location = location;
+            slot.type = type;
+            slot.offset = dataSize;
+            slot.components = components;
+            slot.integer = is_integer_type(type);
+            slot.sampler = -1;
+            slot.dirty = false;
+            dataSize += components;
+
+            if (is_sampler_type(type)) {
+                // Assign each sampler its own texture unit, uploaded on the
+                // first activation
+                slot.sampler = numSamplers++;
+                slot.dirty = true;
+                _dirtyUniforms.push_back(_uniforms.size());
+            }
+
+            if ((unsigned int)location >= _uniformSlotsByLocation.size()) {
+                _uniformSlotsByLocation.resize(location + 1, -1);
+            }
+            _uniformSlotsByLocation[location] = _uniforms.size();
+            _uniforms.push_back(slot);
+
+            _uniformNameMap[elementName] = location;
+            _uniformHashes.push_back(UniformHash{uniform_hash(elementName.c_str()), location, elementName});
+            if (e == 0 && array) {
+                _uniformNameMap[baseName] = location;
+                _uniformHashes.push_back(UniformHash{uniform_hash(baseName.c_str()), location, baseName});
+            }
+        }
     }
-    for (auto& pair : _floatUniformCache) {
-        glUniform1f(pair.first, pair.second);
+
+    // Sort the hashes for binary searches, colliding names are told apart by
+    // _find_uniform()
+    std::sort(
+        _uniformHashes.begin(),
+        _uniformHashes.end(),
+        [](const UniformHash& a, const UniformHash& b) { return a.hash < b.hash; }
+    );
+
+    _uniformData.assign(dataSize, 0.0f);
+    _samplerTextures.assign(numSamplers, nullptr);
+    for (const UniformSlot& slot : _uniforms) {
+        if (slot.sampler >= 0) {
+            int unit = slot.sampler;
+            std::memcpy(&_uniformData[slot.offset], &unit, sizeof(int));
+        }
     }
-    for (auto& pair : _vec2UniformCache) {
-        glUniform2fv(pair.first, 1, pair.second.data());
+}
+
+
+int Shader::_find_uniform(UniformName u) const {
+    auto it = std::lower_bound(
+        _uniformHashes.begin(),
+        _uniformHashes.end(),
+        u.hash(),
+        [](const UniformHash& a, std::uint32_t hash) { return a.hash < hash; }
+    );
+
+    // A hash match alone could be a collision with another name
+    for (; it != _uniformHashes.end() && it->hash == u.hash(); ++it) {
+        if (it->name == u.str()) {
+            return it->location;
+        }
     }
-    for (auto& pair : _vec3UniformCache) {
-        glUniform3fv(pair.first, 1, pair.second.data());
+    return -1;
+}
+
+
+void Shader::_store_uniform(unsigned int u, const void* value, unsigned int components, bool integer) {
+    _finalize();
+    if (u >= _uniformSlotsByLocation.size() || _uniformSlotsByLocation[u] < 0) {
+        // Unknown locations (e.g. -1 for missing uniforms) are ignored like GL does
+        return;
     }
-    for (auto& pair : _vec4UniformCache) {
-        glUniform4fv(pair.first, 1, pair.second.data());
+    unsigned int index = _uniformSlotsByLocation[u];
+    UniformSlot& slot = _uniforms[index];
+    // Samplers keep the texture unit they were assigned, which
+    // set_uniform_sampler() binds textures to
+    if (slot.components != components || slot.integer != integer || slot.sampler >= 0) {
+        std::cerr << "Warning: uniform at location " << u << " set with mismatching type" << std::endl;
+        return;
     }
-    for (auto& pair : _mat3UniformCache) {
-        glUniformMatrix3fv(pair.first, 1, GL_FALSE, pair.second.data());
+
+    float* stored = &_uniformData[slot.offset];
+    if (std::memcmp(stored, value, components * sizeof(float)) == 0) {
+        return;
     }
-    for (auto& pair : _mat4UniformCache) {
-        glUniformMatrix4fv(pair.first, 1, GL_FALSE, pair.second.data());
+    std::memcpy(stored, value, components * sizeof(float));
+
+    if (is_active()) {
+        _upload_uniform(slot);
+    } else if (!slot.dirty) {
+        slot.dirty = true;
+        _dirtyUniforms.push_back(index);
     }
+}
 
-    unsigned int i = 0;
-    for (auto& pair : _samplerUniformCache) {
-        c->bind_texture(*pair.second, i);
-        glUniform1i(pair.first, i);
-        _samplerBindingLocations[pair.first] = i;
-        i += 1;
+
+int Shader::_typed_location(unsigned int u, unsigned int components, bool integer, bool sampler) const {
+    if (u >= _uniformSlotsByLocation.size() || _uniformSlotsByLocation[u] < 0) {
+        return -1;
+    }
+    const UniformSlot& slot = _uniforms[_uniformSlotsByLocation[u]];
+    if (slot.components != components || slot.integer != integer || (slot.sampler >= 0) != sampler) {
+        std::cerr << "Warning: uniform at location " << u << " requested with mismatching type" << std::endl;
+        return -1;
     }
+    return u;
 }
 
 
-void Shader::_deactivate() {
-    _activeContext = nullptr;
+void Shader::_upload_uniform(const UniformSlot& slot) const {
+    const float* f = &_uniformData[slot.offset];
+    const GLint* i = reinterpret_cast<const GLint*>(f);
+    const GLuint* ui = reinterpret_cast<const GLuint*>(f);
+
+    switch (slot.type) {
+        case GL_FLOAT: glUniform1fv(slot.location, 1, f); break;
+        case GL_FLOAT_VEC2: glUniform2fv(slot.location, 1, f); break;
+        case GL_FLOAT_VEC3: glUniform3fv(slot.location, 1, f); break;
+        case GL_FLOAT_VEC4: glUniform4fv(slot.location, 1, f); break;
+        case GL_FLOAT_MAT2: glUniformMatrix2fv(slot.location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(slot.location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(slot.location, 1, GL_FALSE, f); break;
+        case GL_UNSIGNED_INT: glUniform1uiv(slot.location, 1, ui); break;
+        case GL_UNSIGNED_INT_VEC2: glUniform2uiv(slot.location, 1, ui); break;
+        case GL_UNSIGNED_INT_VEC3: glUniform3uiv(slot.location, 1, ui); break;
+        case GL_UNSIGNED_INT_VEC4: glUniform4uiv(slot.location, 1, ui); break;
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2: glUniform2iv(slot.location, 1, i); break;
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3: glUniform3iv(slot.location, 1, i); break;
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4: glUniform4iv(slot.location, 1, i); break;
+        default: glUniform1iv(slot.location, 1, i); break;
+    }
 }
 
 
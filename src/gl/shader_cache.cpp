@@ -0,0 +1,244 @@
+#include <jelly/gl/shader_cache.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <GL/glew.h>
+
+namespace {
+
+
+const char CACHE_MAGIC[4] = {'J', 'L', 'Y', 'P'};
+const std::uint32_t CACHE_VERSION = 1;
+
+
+std::string cacheDirectory;
+jelly::ShaderCache::Stats cacheStats = {};
+
+
+/**
+ * Continues a 64-bit FNV-1a hash over the given string, including its
+ * terminating null character to separate consecutive strings.
+ */
+std::uint64_t hash_string(const char* s, std::uint64_t h) {
+    if (s) {
+        for (; *s; ++s) {
+            h = (h ^ (std::uint8_t)*s) * 1099511628211ull;
+        }
+    }
+    return h * 1099511628211ull;
+}
+
+
+/**
+ * Returns the cache key of a program, identifying both the sources and the
+ * driver that produced the binary.
+ */
+std::uint64_t program_key(const std::string& vs, const std::string& fs) {
+    std::uint64_t h = 14695981039346656037ull;
+    h = hash_string(vs.c_str(), h);
+    h = hash_string(fs.c_str(), h);
+    h = hash_string((const char*)glGetString(GL_VENDOR), h);
+    h = hash_string((const char*)glGetString(GL_RENDERER), h);
+    h = hash_string((const char*)glGetString(GL_VERSION), h);
+    return h;
+}
+
+
+/**
+ * Returns the cache file of a program key.
+ */
+std::string program_path(std::uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return cacheDirectory + "/" + name;
+}
+
+
+/**
+ * Reads a cached program binary, validating the header and the length before
+ * trusting the file.
+ *
+ * \returns
+ *     False if the file is not a complete binary for the key.
+ */
+bool read_binary(std::ifstream& file, std::uint64_t key, GLenum& format, std::vector<char>& binary) {
+    char magic[4] = {};
+    std::uint32_t version = 0, storedFormat = 0, length = 0;
+    std::uint64_t storedKey = 0;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&storedKey, sizeof(storedKey));
+    file.read((char*)&storedFormat, sizeof(storedFormat));
+    file.read((char*)&length, sizeof(length));
+    if (!file
+        || !std::equal(magic, magic + 4, CACHE_MAGIC)
+        || version != CACHE_VERSION
+        || storedKey != key) {
+        return false;
+    }
+
+    // A corrupt length must not allocate more than the file holds
+    std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff end = file.tellg();
+    if (start < 0 || end < 0 || (std::uint64_t)(end - start) != length) {
+        return false;
+    }
+    file.seekg(start);
+
+    format = storedFormat;
+    binary.resize(length);
+    return (bool)file.read(binary.data(), length);
+}
+
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+}
+
+
+namespace jelly {
+
+
+void ShaderCache::set_directory(const std::string& path) {
+    cacheDirectory = path;
+    if (!path.empty()) {
+        // Fails harmlessly if the directory exists already
+        mkdir(path.c_str(), 0755);
+    }
+}
+
+
+const std::string& ShaderCache::get_directory() {
+    return cacheDirectory;
+}
+
+
+bool ShaderCache::is_enabled() {
+    if (cacheDirectory.empty() || !GLEW_ARB_get_program_binary) {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+
+ShaderCache::Stats ShaderCache::get_stats() {
+    Stats stats = cacheStats;
+    if (stats.misses > 0) {
+        double average = stats.compile_seconds / stats.misses;
+        stats.saved_seconds = average * stats.hits - stats.load_seconds;
+    }
+    return stats;
+}
+
+
+void ShaderCache::reset_stats() {
+    cacheStats = Stats();
+}
+
+
+unsigned int ShaderCache::_load(const std::string& vs, const std::string& fs) {
+    if (!is_enabled()) {
+        return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    std::uint64_t key = program_key(vs, fs);
+    std::string path = program_path(key);
+    GLenum format = 0;
+    std::vector<char> binary;
+    bool exists = false, valid = false;
+    try {
+        std::ifstream file(path, std::ios::binary);
+        exists = (bool)file;
+        valid = exists && read_binary(file, key, format, binary);
+    }
+    catch (const std::exception&) {
+        // Any failure to read the file is a miss, compiling the sources instead
+        valid = false;
+    }
+    if (!valid) {
+        if (exists) {
+            cacheStats.rejected += 1;
+        }
+        cacheStats.misses += 1;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), binary.size());
+    GLint result = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+        // The driver no longer accepts the binary, it is replaced after
+        // compiling the sources again
+        glDeleteProgram(program);
+        cacheStats.rejected += 1;
+        cacheStats.misses += 1;
+        return 0;
+    }
+
+    cacheStats.hits += 1;
+    cacheStats.load_seconds += seconds_since(start);
+    return program;
+}
+
+
+void ShaderCache::_store(unsigned int program, const std::string& vs, const std::string& fs, double seconds) {
+    cacheStats.compile_seconds += seconds;
+    if (!is_enabled()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    std::uint64_t key = program_key(vs, fs);
+    std::uint32_t storedFormat = format, storedLength = length;
+    // Write to a file of this process and rename it, which is atomic, so
+    // that other processes never read a partially written binary
+    std::string path = program_path(key);
+    std::string temporary = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        file.write((const char*)&CACHE_VERSION, sizeof(CACHE_VERSION));
+        file.write((const char*)&key, sizeof(key));
+        file.write((const char*)&storedFormat, sizeof(storedFormat));
+        file.write((const char*)&storedLength, sizeof(storedLength));
+        file.write(binary.data(), length);
+        if (!file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+
+}
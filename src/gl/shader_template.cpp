@@ -0,0 +1,138 @@
+#include <jelly/gl/shader_template.hpp>
+
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+
+
+/**
+ * Returns true if the code contains the given identifier as a whole word.
+ */
+bool references(const std::string& code, const std::string& name) {
+    std::string::size_type pos = code.find(name);
+    while (pos != std::string::npos) {
+        std::string::size_type end = pos + name.size();
+        bool startsWord = pos == 0 || !(std::isalnum(code[pos - 1]) || code[pos - 1] == '_');
+        bool endsWord = end == code.size() || !(std::isalnum(code[end]) || code[end] == '_');
+        if (startsWord && endsWord) {
+            return true;
+        }
+        pos = code.find(name, pos + 1);
+    }
+    return false;
+}
+
+
+}
+
+
+namespace jelly {
+
+
+ShaderTemplate::ShaderTemplate(const std::string& vs, const std::string& fs, Shader::Compilation mode) :
+    _vertexCode(vs),
+    _fragmentCode(fs),
+    _mode(mode),
+    _usedBits(0),
+    _referencedMask(0)
+{}
+
+
+ShaderTemplate::~ShaderTemplate() {}
+
+
+ShaderTemplate::Feature ShaderTemplate::add_feature(const std::string& name) {
+    return add_feature(name, 1);
+}
+
+
+ShaderTemplate::Feature ShaderTemplate::add_feature(const std::string& name, unsigned int max) {
+    unsigned int bits = 1;
+    while (bits < 32 && (max >> bits) != 0) {
+        bits += 1;
+    }
+    if (_usedBits + bits > 64) {
+        throw std::runtime_error("Too many shader template features");
+    }
+
+    Feature feature(_usedBits, bits, max);
+    _usedBits += bits;
+
+    FeatureInfo info = {
+        name,
+        feature,
+        references(_vertexCode, name),
+        references(_fragmentCode, name)
+    };
+    if (info.inVertex || info.inFragment) {
+        _referencedMask |= ((Key(1) << bits) - 1) << feature._offset;
+    }
+    _features.push_back(info);
+
+    return feature;
+}
+
+
+Shader& ShaderTemplate::get(Key key) {
+    return _variant(key, _mode);
+}
+
+
+void ShaderTemplate::prepare(Key key) {
+    _variant(key, Shader::Compilation::DEFERRED);
+}
+
+
+std::string ShaderTemplate::generate_vertex_code(Key key) const {
+    return _generate(_vertexCode, key, true);
+}
+
+
+std::string ShaderTemplate::generate_fragment_code(Key key) const {
+    return _generate(_fragmentCode, key, false);
+}
+
+
+Shader& ShaderTemplate::_variant(Key key, Shader::Compilation mode) {
+    // Values of unreferenced features cannot change the code
+    key &= _referencedMask;
+
+    auto it = _shaders.find(key);
+    if (it != _shaders.end()) {
+        return *it->second;
+    }
+
+    Shader* shader = new Shader(
+        generate_vertex_code(key),
+        generate_fragment_code(key),
+        mode
+    );
+    _shaders[key].reset(shader);
+    return *shader;
+}
+
+
+std::string ShaderTemplate::_generate(const std::string& code, Key key, bool vertex) const {
+    std::string defines;
+    for (const FeatureInfo& info : _features) {
+        if (vertex ? info.inVertex : info.inFragment) {
+            Key value = (key >> info.feature._offset) & ((Key(1) << info.feature._bits) - 1);
+            defines += "#define " + info.name + " " + std::to_string(value) + "\n";
+        }
+    }
+
+    // The defines must follow the #version directive, which has to come first
+    std::string::size_type version = code.find("#version");
+    if (version == std::string::npos) {
+        return defines + code;
+    }
+    std::string::size_type lineEnd = code.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return code + "\n" + defines;
+    }
+    return code.substr(0, lineEnd + 1) + defines + code.substr(lineEnd + 1);
+}
+
+
+}
@@ -0,0 +1,115 @@
+#include <jelly/gl/shape_batch.hpp>
+
+#include <cstddef>
+
+#include <GL/glew.h>
+
+#include <jelly/gl/context.hpp>
+#include <jelly/gl/mesh.hpp>
+#include <jelly/gl/shader.hpp>
+
+namespace {
+
+
+using namespace jelly;
+
+
+/**
+ * Points the instance attributes of the bound vertex array at instances
+ * starting at offset in the bound array buffer.
+ */
+void set_instance_attributes(std::size_t offset) {
+    const GLsizei stride = sizeof(ShapeInstance);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(ShapeInstance, rect)));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(ShapeInstance, color)));
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(ShapeInstance, stroke)));
+    glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(ShapeInstance, radius)));
+    glVertexAttribIPointer(7, 1, GL_INT, stride, (void*)(offset + offsetof(ShapeInstance, type)));
+}
+
+
+}
+
+
+namespace jelly {
+
+
+ShapeBatch::ShapeBatch(const Mesh& quad) :
+    _shader(nullptr),
+    _vao(0),
+    _numIndices(quad.get_index_count()),
+    _indexType(quad.get_index_type()),
+    _flushCount(0),
+    _shapeCount(0)
+{
+    glGenVertexArrays(1, &_vao);
+    glBindVertexArray(_vao);
+
+    // Share the quad's buffers, in whatever layout it uses
+    quad._bind_attributes();
+
+    // Configure the per-instance attributes, which point into the transient
+    // buffer of each flush
+    for (unsigned int location = 3; location <= 7; ++location) {
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+
+    glBindVertexArray(0);
+    Context::_notify_vertex_array(0);
+}
+
+
+ShapeBatch::~ShapeBatch() {
+    if (_vao) {
+        glDeleteVertexArrays(1, &_vao);
+        Context::_notify_deleted_vertex_array(_vao);
+    }
+}
+
+
+void ShapeBatch::append(Context& c, Shader& shader, const ShapeInstance& shape) {
+    if (!_instances.empty() && _shader != &shader) {
+        flush(c);
+    }
+    _shader = &shader;
+    _instances.push_back(shape);
+}
+
+
+void ShapeBatch::flush(Context& c) {
+    if (_instances.empty()) {
+        return;
+    }
+
+    // Take the pending instances first, as activating the shader flushes the
+    // context, which flushes this batch again
+    std::vector<ShapeInstance> instances;
+    instances.swap(_instances);
+    c.activate_shader(*_shader);
+
+    // Write the instances to the transient buffer, which never waits for
+    // the draws of previous frames, and point the attributes at them
+    unsigned int count = instances.size();
+    TransientRange range = c.get_transient_buffer().upload(instances.data(), count * sizeof(ShapeInstance));
+
+    c._bind_vertex_array(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, range.buffer);
+    set_instance_attributes(range.offset);
+    glDrawElementsInstanced(GL_TRIANGLES, _numIndices, _indexType, 0, count);
+
+    // Keep the storage for the next shapes
+    instances.clear();
+    _instances.swap(instances);
+    _flushCount += 1;
+    _shapeCount += count;
+}
+
+
+void ShapeBatch::reset_counters() {
+    _flushCount = 0;
+    _shapeCount = 0;
+}
+
+
+}
@@ -2,6 +2,8 @@
 
 #include <stdexcept>
 
+#include <jelly/gl/context.hpp>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
@@ -19,6 +21,7 @@ Texture::Texture(int width, int height, Format format, Filter filter, Type type)
 
     unsigned int bindTarget = (type == Type::TEXTURE_2D ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP);
     glBindTexture(bindTarget, _handle);
+    Context::_notify_texture(bindTarget, _handle);
     glTexParameteri(bindTarget, GL_TEXTURE_MIN_FILTER, (unsigned int)filter);
     glTexParameteri(bindTarget, GL_TEXTURE_MAG_FILTER, (unsigned int)filter);
 
@@ -103,6 +106,7 @@ Texture::Texture(std::string path, Filter filter, bool srgb) :
     if (data) {
         glGenTextures(1, &_handle);
         glBindTexture(GL_TEXTURE_2D, _handle);
+        Context::_notify_texture(GL_TEXTURE_2D, _handle);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (unsigned int)filter);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (unsigned int)filter);
 
@@ -179,6 +183,7 @@ Texture::Texture(std::string fns[6], Filter filter, bool srgb) :
 
     glGenTextures(1, &_handle);
     glBindTexture(GL_TEXTURE_CUBE_MAP, _handle);
+    Context::_notify_texture(GL_TEXTURE_CUBE_MAP, _handle);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, (unsigned int)filter);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, (unsigned int)filter);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -224,6 +229,7 @@ Texture::Texture(const Vec3& v) :
 {
     glGenTextures(1, &_handle);
     glBindTexture(GL_TEXTURE_2D, _handle);
+    Context::_notify_texture(GL_TEXTURE_2D, _handle);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_FLOAT, v.data());
 }
@@ -231,18 +237,20 @@ Texture::Texture(const Vec3& v) :
 
 Texture::~Texture() {
     glDeleteTextures(1, &_handle);
+    Context::_notify_deleted_texture(_handle);
 }
 
 
 void Texture::generate_mipmaps() {
-    glBindTexture(GL_TEXTURE_2D, _handle);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    unsigned int target = _gl_target();
+    glBindTexture(target, _handle);
+    Context::_notify_texture(target, _handle);
+    glGenerateMipmap(target);
 }
 
 
-void Texture::_bind(unsigned int i) const {
-    glActiveTexture(GL_TEXTURE0 + i);
-    glBindTexture(GL_TEXTURE_2D, _handle);
+unsigned int Texture::_gl_target() const {
+    return _type == Type::TEXTURE_CUBE ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
 }
 
 
@@ -0,0 +1,212 @@
+#include <jelly/gl/transient_buffer.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <jelly/math/common.hpp>
+
+namespace {
+
+
+/**
+ * How long to wait for a fence before checking it again, in nanoseconds.
+ */
+const GLuint64 FENCE_TIMEOUT = 1000000;
+
+
+unsigned int align(unsigned int offset, unsigned int alignment) {
+    return alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset;
+}
+
+
+/**
+ * Blocks until the GPU has passed a fence, then deletes it.
+ */
+void wait_fence(GLsync fence) {
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true) {
+        GLenum status = glClientWaitSync(fence, flags, FENCE_TIMEOUT);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED) {
+            break;
+        }
+        flags = 0;
+    }
+    glDeleteSync(fence);
+}
+
+
+}
+
+
+namespace jelly {
+
+
+TransientBuffer::TransientBuffer(unsigned int frameSize) :
+    _handle(0),
+    _mapping(nullptr),
+    _persistent(GLEW_ARB_buffer_storage),
+    _mapped(false),
+    _frameSize(0),
+    _frame(0),
+    _offset(0),
+    _used(0),
+    _uniformAlignment(256),
+    _fences{}
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    _uniformAlignment = alignment;
+    _create(frameSize);
+}
+
+
+TransientBuffer::~TransientBuffer() {
+    _unmap();
+    for (GLsync& fence : _fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    for (Retired& retired : _retired) {
+        if (retired.fence) {
+            glDeleteSync(retired.fence);
+        }
+        glDeleteBuffers(1, &retired.handle);
+    }
+    if (_handle) {
+        glDeleteBuffers(1, &_handle);
+    }
+}
+
+
+TransientRange TransientBuffer::allocate(unsigned int size, unsigned int alignment) {
+    _unmap();
+
+    unsigned int start = align(_frame * _frameSize + _offset, alignment);
+    if (start + size > (_frame + 1) * _frameSize) {
+        _grow(size + alignment);
+        start = align(_frame * _frameSize, alignment);
+    }
+    _used += start + size - (_frame * _frameSize + _offset);
+    _offset = start + size - _frame * _frameSize;
+
+    TransientRange range = {nullptr, _handle, start, size};
+    if (_persistent) {
+        range.data = _mapping + start;
+    }
+    else if (size > 0) {
+        // The fences guarantee that the GPU is done with the range
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+        range.data = glMapBufferRange(
+            GL_COPY_WRITE_BUFFER,
+            start,
+            size,
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+        );
+        if (!range.data) {
+            throw std::runtime_error("Could not map transient buffer");
+        }
+        _mapped = true;
+    }
+    return range;
+}
+
+
+void TransientBuffer::commit(const TransientRange& range) {
+    // Coherent mappings need nothing more
+    if (range.buffer == _handle) {
+        _unmap();
+    }
+}
+
+
+TransientRange TransientBuffer::upload(const void* data, unsigned int size, unsigned int alignment) {
+    TransientRange range = allocate(size, alignment);
+    if (size > 0) {
+        std::memcpy(range.data, data, size);
+    }
+    commit(range);
+    return range;
+}
+
+
+void TransientBuffer::_create(unsigned int frameSize) {
+    _frameSize = frameSize;
+    _frame = 0;
+    _offset = 0;
+
+    glGenBuffers(1, &_handle);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+    if (_persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, FRAME_COUNT * frameSize, nullptr, flags);
+        _mapping = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, FRAME_COUNT * frameSize, flags);
+        if (!_mapping) {
+            throw std::runtime_error("Could not map transient buffer");
+        }
+    }
+    else {
+        glBufferData(GL_COPY_WRITE_BUFFER, FRAME_COUNT * frameSize, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+
+void TransientBuffer::_grow(unsigned int size) {
+    // The ranges already allocated this frame stay valid in the retired
+    // buffer, which is deleted once the GPU has read them
+    _retired.push_back(Retired{_handle, nullptr});
+    for (GLsync& fence : _fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    _mapping = nullptr;
+    _create(MAX(2 * _frameSize, size));
+}
+
+
+void TransientBuffer::_unmap() {
+    if (_mapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        _mapped = false;
+    }
+}
+
+
+void TransientBuffer::_end_frame() {
+    _unmap();
+
+    _fences[_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    for (Retired& retired : _retired) {
+        if (!retired.fence) {
+            retired.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
+
+    // Wait for the GPU to finish reading the next region, usually long done
+    _frame = (_frame + 1) % FRAME_COUNT;
+    _offset = 0;
+    _used = 0;
+    if (_fences[_frame]) {
+        wait_fence(_fences[_frame]);
+        _fences[_frame] = nullptr;
+    }
+
+    // Delete the outgrown buffers the GPU is done with, without waiting
+    for (unsigned int i = 0; i < _retired.size();) {
+        if (glClientWaitSync(_retired[i].fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+            glDeleteSync(_retired[i].fence);
+            glDeleteBuffers(1, &_retired[i].handle);
+            _retired[i] = _retired.back();
+            _retired.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,104 @@
+#include <jelly/gl/uniform_buffer.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <GL/glew.h>
+
+#include <jelly/gl/context.hpp>
+
+namespace jelly {
+
+
+UniformBuffer::UniformBuffer(const Std140Layout& layout) :
+    UniformBuffer(layout.get_size())
+{}
+
+
+UniformBuffer::UniformBuffer(unsigned int size) :
+    _handle(0),
+    _data(size, 0),
+    _dirtyBegin(size),
+    _dirtyEnd(0)
+{
+    glGenBuffers(1, &_handle);
+    glBindBuffer(GL_UNIFORM_BUFFER, _handle);
+    glBufferData(GL_UNIFORM_BUFFER, size, _data.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+
+UniformBuffer::~UniformBuffer() {
+    if (_handle) {
+        glDeleteBuffers(1, &_handle);
+        Context::_notify_deleted_buffer(_handle);
+    }
+}
+
+
+void UniformBuffer::set_float(unsigned int offset, float f) {
+    _write(offset, &f, sizeof(float));
+}
+
+
+void UniformBuffer::set_int(unsigned int offset, int i) {
+    _write(offset, &i, sizeof(int));
+}
+
+
+void UniformBuffer::set_vec2(unsigned int offset, const Vec2& v) {
+    _write(offset, v.data(), 2 * sizeof(float));
+}
+
+
+void UniformBuffer::set_vec3(unsigned int offset, const Vec3& v) {
+    _write(offset, v.data(), 3 * sizeof(float));
+}
+
+
+void UniformBuffer::set_vec4(unsigned int offset, const Vec4& v) {
+    _write(offset, v.data(), 4 * sizeof(float));
+}
+
+
+void UniformBuffer::set_mat3(unsigned int offset, const Mat3& m) {
+    // std140 pads each column to a vec4
+    for (unsigned int c = 0; c < 3; ++c) {
+        _write(offset + 16 * c, m.data() + 3 * c, 3 * sizeof(float));
+    }
+}
+
+
+void UniformBuffer::set_mat4(unsigned int offset, const Mat4& m) {
+    _write(offset, m.data(), 16 * sizeof(float));
+}
+
+
+void UniformBuffer::upload() {
+    if (_dirtyBegin < _dirtyEnd) {
+        glBindBuffer(GL_UNIFORM_BUFFER, _handle);
+        glBufferSubData(GL_UNIFORM_BUFFER, _dirtyBegin, _dirtyEnd - _dirtyBegin, _data.data() + _dirtyBegin);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        _dirtyBegin = _data.size();
+        _dirtyEnd = 0;
+    }
+}
+
+
+void UniformBuffer::_write(unsigned int offset, const void* data, unsigned int size) {
+    if (offset + size > _data.size()) {
+        throw std::runtime_error("Uniform buffer write out of range");
+    }
+    if (std::memcmp(&_data[offset], data, size) != 0) {
+        std::memcpy(&_data[offset], data, size);
+        if (offset < _dirtyBegin) {
+            _dirtyBegin = offset;
+        }
+        if (offset + size > _dirtyEnd) {
+            _dirtyEnd = offset + size;
+        }
+    }
+}
+
+
+}
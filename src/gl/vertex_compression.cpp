@@ -0,0 +1,259 @@
+#include <jelly/gl/vertex_compression.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <jelly/math/bounds.hpp>
+#include <jelly/math/packing.hpp>
+
+namespace {
+
+
+using namespace jelly;
+
+static_assert(sizeof(Vec2) == 2*sizeof(float), "Vec2 arrays must be tightly packed");
+static_assert(sizeof(Vec3) == 3*sizeof(float), "Vec3 arrays must be tightly packed");
+
+
+/**
+ * Copies consecutive elements of a given size into the vertices of an
+ * interleaved buffer.
+ */
+void scatter(const void* elements, std::size_t size, std::size_t count,
+             unsigned char* vertices, unsigned int stride) {
+    const unsigned char* src = (const unsigned char*)elements;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::memcpy(vertices + i * stride, src + i * size, size);
+    }
+}
+
+
+/**
+ * Writes the octahedral encodings of normals into the vertices, and sets the
+ * largest angle to their decodings if error is not null.
+ */
+template <typename Int>
+void compress_normals(const std::vector<Vec3>& normals, unsigned char* vertices, unsigned int stride,
+                      float* error) {
+    std::vector<Int> packed(2 * normals.size());
+    pack_octahedral(normals.data(), packed.data(), normals.size());
+    scatter(packed.data(), 2 * sizeof(Int), normals.size(), vertices, stride);
+
+    if (error) {
+        for (std::size_t i = 0; i < normals.size(); ++i) {
+            float cs = dot(normalize(normals[i]), unpack_octahedral(&packed[2*i]));
+            float angle = std::acos(cs < 1.0f ? cs : 1.0f);
+            *error = angle > *error ? angle : *error;
+        }
+    }
+}
+
+
+float max_distance(const Vec3& a, const Vec3& b, float error) {
+    float d = magnitude(a - b);
+    return d > error ? d : error;
+}
+
+
+float max_distance(const Vec2& a, const Vec2& b, float error) {
+    float d = magnitude(a - b);
+    return d > error ? d : error;
+}
+
+
+}
+
+
+namespace jelly {
+
+
+const char* const VertexCompression::DECODE_GLSL = R"(
+vec3 jelly_decode_octahedral(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.x += v.x >= 0.0 ? -t : t;
+    v.y += v.y >= 0.0 ? -t : t;
+    return normalize(v);
+}
+
+vec3 jelly_decode_octahedral16(vec2 q) {
+    return jelly_decode_octahedral(max(q / 32767.0, -1.0));
+}
+
+vec3 jelly_decode_octahedral8(vec2 q) {
+    return jelly_decode_octahedral(max(q / 127.0, -1.0));
+}
+)";
+
+
+VertexCompression::VertexCompression(Position position, Normal normal, Uv uv) :
+    _position(position),
+    _normal(normal),
+    _uv(uv)
+{}
+
+
+VertexFormat VertexCompression::get_format() const {
+    typedef VertexFormat::Type Type;
+    VertexFormat format;
+
+    switch (_position) {
+        case Position::FLOAT:
+            format.add(0, 3, Type::FLOAT);
+            break;
+        case Position::HALF:
+            format.add(0, 3, Type::HALF_FLOAT);
+            break;
+        case Position::UNORM16:
+            format.add(0, 3, Type::UNSIGNED_SHORT, true);
+            break;
+    }
+
+    switch (_normal) {
+        case Normal::FLOAT:
+            format.add(1, 3, Type::FLOAT);
+            break;
+        // Not normalized, as GL 3.3 normalizes signed integers differently
+        // from later versions, so the shader divides them as the CPU does
+        case Normal::OCTAHEDRAL16:
+            format.add(1, 2, Type::SHORT);
+            break;
+        case Normal::OCTAHEDRAL8:
+            format.add(1, 2, Type::BYTE);
+            break;
+    }
+
+    switch (_uv) {
+        case Uv::FLOAT:
+            format.add(2, 2, Type::FLOAT);
+            break;
+        case Uv::HALF:
+            format.add(2, 2, Type::HALF_FLOAT);
+            break;
+        case Uv::UNORM16:
+            format.add(2, 2, Type::UNSIGNED_SHORT, true);
+            break;
+    }
+    return format;
+}
+
+
+std::vector<unsigned char> VertexCompression::compress(
+    const std::vector<Vec3>& vertices,
+    const std::vector<Vec3>& normals,
+    const std::vector<Vec2>& uvs,
+    Mat4& positionTransform,
+    CompressionReport* report
+) const {
+    if (normals.size() != vertices.size() || uvs.size() != vertices.size()) {
+        throw std::runtime_error("Vertex attributes differ in length");
+    }
+
+    VertexFormat format = get_format();
+    std::size_t n = vertices.size();
+    unsigned int stride = format.get_stride(0);
+    std::vector<unsigned char> data(n * stride);
+    unsigned char* position = data.data() + format.get_attribute(0)->offset;
+    unsigned char* normal = data.data() + format.get_attribute(1)->offset;
+    unsigned char* uv = data.data() + format.get_attribute(2)->offset;
+
+    CompressionReport errors = {0.0f, 0.0f, 0.0f, stride};
+
+    // Quantize the positions relative to their bounds, which the GPU restores
+    // with the position transform
+    Aabb bounds;
+    for (const Vec3& v : vertices) {
+        bounds.expand(v);
+    }
+    positionTransform = Mat4(1.0f);
+
+    if (_position == Position::FLOAT || n == 0) {
+        scatter(vertices.data(), sizeof(Vec3), n, position, stride);
+    }
+    else {
+        Vec3 origin = bounds.center();
+        Vec3 scale(1.0f);
+        if (_position == Position::UNORM16) {
+            origin = bounds.min;
+            for (std::size_t c = 0; c < 3; ++c) {
+                float size = bounds.max[c] - bounds.min[c];
+                scale[c] = size > 0.0f ? size : 1.0f;
+            }
+        }
+        positionTransform = Mat4::translation(origin);
+        for (std::size_t c = 0; c < 3; ++c) {
+            positionTransform(c, c) = scale[c];
+        }
+
+        std::vector<float> relative(3 * n);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t c = 0; c < 3; ++c) {
+                relative[3*i + c] = (vertices[i][c] - origin[c]) / scale[c];
+            }
+        }
+        std::vector<std::uint16_t> packed(3 * n);
+        if (_position == Position::HALF) {
+            pack_half(relative.data(), packed.data(), packed.size());
+        }
+        else {
+            pack_unorm16(relative.data(), packed.data(), packed.size());
+        }
+        scatter(packed.data(), 3 * sizeof(std::uint16_t), n, position, stride);
+
+        if (report) {
+            for (std::size_t i = 0; i < n; ++i) {
+                Vec3 decoded;
+                for (std::size_t c = 0; c < 3; ++c) {
+                    std::uint16_t q = packed[3*i + c];
+                    float v = _position == Position::HALF ? unpack_half(q) : unpack_unorm16(q);
+                    decoded[c] = origin[c] + scale[c] * v;
+                }
+                errors.position_error = max_distance(vertices[i], decoded, errors.position_error);
+            }
+        }
+    }
+
+    if (_normal == Normal::FLOAT) {
+        scatter(normals.data(), sizeof(Vec3), n, normal, stride);
+    }
+    else if (_normal == Normal::OCTAHEDRAL16) {
+        compress_normals<std::int16_t>(normals, normal, stride, report ? &errors.normal_error : nullptr);
+    }
+    else {
+        compress_normals<std::int8_t>(normals, normal, stride, report ? &errors.normal_error : nullptr);
+    }
+
+    if (_uv == Uv::FLOAT) {
+        scatter(uvs.data(), sizeof(Vec2), n, uv, stride);
+    }
+    else {
+        const float* coordinates = n > 0 ? uvs[0].data() : nullptr;
+        std::vector<std::uint16_t> packed(2 * n);
+        if (_uv == Uv::HALF) {
+            pack_half(coordinates, packed.data(), packed.size());
+        }
+        else {
+            pack_unorm16(coordinates, packed.data(), packed.size());
+        }
+        scatter(packed.data(), 2 * sizeof(std::uint16_t), n, uv, stride);
+
+        if (report) {
+            for (std::size_t i = 0; i < n; ++i) {
+                Vec2 decoded = _uv == Uv::HALF
+                    ? Vec2(unpack_half(packed[2*i]), unpack_half(packed[2*i + 1]))
+                    : Vec2(unpack_unorm16(packed[2*i]), unpack_unorm16(packed[2*i + 1]));
+                errors.uv_error = max_distance(uvs[i], decoded, errors.uv_error);
+            }
+        }
+    }
+
+    if (report) {
+        *report = errors;
+    }
+    return data;
+}
+
+
+}
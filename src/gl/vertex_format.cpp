@@ -0,0 +1,124 @@
+#include <jelly/gl/vertex_format.hpp>
+
+#include <stdexcept>
+
+namespace jelly {
+
+
+VertexFormat VertexFormat::standard() {
+    VertexFormat format;
+    format.add(0, 3, Type::FLOAT)
+          .add(1, 3, Type::FLOAT)
+          .add(2, 2, Type::FLOAT);
+    return format;
+}
+
+
+VertexFormat::VertexFormat()
+{}
+
+
+VertexFormat& VertexFormat::add(
+    unsigned int location,
+    unsigned int components,
+    Type type,
+    bool normalized,
+    unsigned int stream
+) {
+    bool packed = type == Type::INT_2_10_10_10_REV || type == Type::UNSIGNED_INT_2_10_10_10_REV;
+    if (components < 1 || components > 4 || (packed && components != 4)) {
+        throw std::runtime_error("Vertex attribute with invalid component count");
+    }
+    if (get_attribute(location)) {
+        throw std::runtime_error("Vertex attribute location used twice");
+    }
+    if (stream > _strides.size()) {
+        throw std::runtime_error("Vertex attribute stream skips a stream");
+    }
+    if (stream == _strides.size()) {
+        _strides.push_back(0);
+    }
+
+    Attribute attribute;
+    attribute.location = location;
+    attribute.components = components;
+    attribute.type = type;
+    attribute.normalized = normalized;
+    attribute.integer = false;
+    attribute.stream = stream;
+
+    // Align the attribute to its component size, so that small attributes
+    // such as 2 bytes after a 6-byte position pack without padding
+    unsigned int alignment = packed ? 4 : type_size(type);
+    attribute.offset = (_strides[stream] + alignment - 1) & ~(alignment - 1);
+    _attributes.push_back(attribute);
+
+    _strides[stream] = attribute.offset + (packed ? 4 : components * type_size(type));
+    return *this;
+}
+
+
+VertexFormat& VertexFormat::add_integer(
+    unsigned int location,
+    unsigned int components,
+    Type type,
+    unsigned int stream
+) {
+    if (type == Type::FLOAT || type == Type::HALF_FLOAT ||
+        type == Type::INT_2_10_10_10_REV || type == Type::UNSIGNED_INT_2_10_10_10_REV) {
+        throw std::runtime_error("Integer vertex attribute with non-integer type");
+    }
+    add(location, components, type, false, stream);
+    _attributes.back().integer = true;
+    return *this;
+}
+
+
+VertexFormat& VertexFormat::add_matrix(
+    unsigned int location,
+    unsigned int columns,
+    unsigned int rows,
+    unsigned int stream
+) {
+    for (unsigned int c = 0; c < columns; ++c) {
+        add(location + c, rows, Type::FLOAT, false, stream);
+    }
+    return *this;
+}
+
+
+const VertexFormat::Attribute* VertexFormat::get_attribute(unsigned int location) const {
+    for (const Attribute& attribute : _attributes) {
+        if (attribute.location == location) {
+            return &attribute;
+        }
+    }
+    return nullptr;
+}
+
+
+unsigned int VertexFormat::get_vertex_size() const {
+    unsigned int size = 0;
+    for (unsigned int stream = 0; stream < _strides.size(); ++stream) {
+        size += get_stride(stream);
+    }
+    return size;
+}
+
+
+unsigned int VertexFormat::type_size(Type type) {
+    switch (type) {
+        case Type::BYTE:
+        case Type::UNSIGNED_BYTE:
+            return 1;
+        case Type::HALF_FLOAT:
+        case Type::SHORT:
+        case Type::UNSIGNED_SHORT:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+
+}
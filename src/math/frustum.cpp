@@ -0,0 +1,196 @@
+#include <jelly/math/frustum.hpp>
+
+#include <vector>
+
+#include <jelly/math/simd_ops.hpp>
+
+namespace {
+
+
+using namespace jelly;
+
+#if !defined(JELLY_SIMD_SCALAR)
+using namespace jelly::simd;
+#endif
+
+static_assert(sizeof(Sphere) == 4*sizeof(float), "Sphere arrays must be tightly packed");
+static_assert(sizeof(Aabb) == 6*sizeof(float), "Aabb arrays must be tightly packed");
+
+
+#if !defined(JELLY_SIMD_SCALAR)
+
+/**
+ * The planes of a frustum broadcast to all lanes.
+ */
+struct Planes {
+
+    explicit Planes(const Frustum& frustum)
+    {
+        for (std::size_t i = 0; i < 6; ++i) {
+            const Vec4& plane = frustum.get_plane(i);
+            for (std::size_t c = 0; c < 4; ++c) {
+                p[i][c] = set1(plane[c]);
+            }
+            for (std::size_t c = 0; c < 3; ++c) {
+                positive[i][c] = plane[c] >= 0.0f;
+            }
+        }
+    }
+
+    f32x4 p[6][4];
+    bool positive[6][3];
+
+};
+
+
+/**
+ * Returns the bits of the lanes which are positive or zero.
+ */
+unsigned int inside_bits(f32x4 v) {
+    float t[4];
+    store(t, v);
+    return (t[0] >= 0.0f) | (t[1] >= 0.0f) << 1 | (t[2] >= 0.0f) << 2 | (t[3] >= 0.0f) << 3;
+}
+
+
+/**
+ * Returns the visibility bits of spheres i to i + 3.
+ */
+unsigned int cull4(const Planes& planes, const Sphere* spheres) {
+    f32x4 x, y, z, r;
+    load4x4(spheres[0].center.data(), x, y, z, r);
+
+    f32x4 d[6];
+    for (std::size_t i = 0; i < 6; ++i) {
+        const f32x4* p = planes.p[i];
+        d[i] = add(add(madd(p[2], z, madd(p[1], y, mul(p[0], x))), p[3]), r);
+    }
+    return inside_bits(min(min(min(d[0], d[1]), min(d[2], d[3])), min(d[4], d[5])));
+}
+
+
+/**
+ * Returns the visibility bits of boxes i to i + 3.
+ */
+unsigned int cull4(const Planes& planes, const Aabb* boxes) {
+    // The boxes are 8 consecutive 3D vectors, alternating min and max
+    f32x4 x0, y0, z0, x1, y1, z1;
+    load3x4(boxes[0].min.data(), x0, y0, z0);
+    load3x4(boxes[2].min.data(), x1, y1, z1);
+    f32x4 lo[3];
+    f32x4 hi[3];
+    deinterleave(x0, x1, lo[0], hi[0]);
+    deinterleave(y0, y1, lo[1], hi[1]);
+    deinterleave(z0, z1, lo[2], hi[2]);
+
+    f32x4 d[6];
+    for (std::size_t i = 0; i < 6; ++i) {
+        const f32x4* p = planes.p[i];
+        const bool* positive = planes.positive[i];
+        f32x4 cx = positive[0] ? hi[0] : lo[0];
+        f32x4 cy = positive[1] ? hi[1] : lo[1];
+        f32x4 cz = positive[2] ? hi[2] : lo[2];
+        d[i] = add(madd(p[2], cz, madd(p[1], cy, mul(p[0], cx))), p[3]);
+    }
+    return inside_bits(min(min(min(d[0], d[1]), min(d[2], d[3])), min(d[4], d[5])));
+}
+
+#endif
+
+
+/**
+ * Calls emit(i, visible) for each volume in order.
+ */
+template <typename Volume, typename Emit>
+void cull_volumes(const Frustum& frustum, const Volume* volumes, std::size_t count, const Emit& emit) {
+    std::size_t i = 0;
+#if !defined(JELLY_SIMD_SCALAR)
+    Planes planes(frustum);
+    for (; i + 4 <= count; i += 4) {
+        unsigned int bits = cull4(planes, volumes + i);
+        for (unsigned int k = 0; k < 4; ++k) {
+            emit(i + k, ((bits >> k) & 1) != 0);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        emit(i, frustum.intersects(volumes[i]));
+    }
+}
+
+
+/**
+ * Compares the visibility of each volume to the scalar test.
+ */
+template <typename Volume>
+void verify(const Frustum& frustum, const Volume* volumes, const std::vector<float>& result) {
+    std::vector<float> reference(result.size());
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        reference[i] = frustum.intersects(volumes[i]) ? 1.0f : 0.0f;
+    }
+    simd::_verify("cull", result.data(), reference.data(), (unsigned int)result.size());
+}
+
+
+template <typename Volume>
+void cull_mask(const Frustum& frustum, const Volume* volumes, std::size_t count, std::uint8_t* visible) {
+    cull_volumes(frustum, volumes, count, [visible](std::size_t i, bool v) {
+        visible[i] = v ? 1 : 0;
+    });
+
+    if (simd::is_verifying() && count > 0) {
+        verify(frustum, volumes, std::vector<float>(visible, visible + count));
+    }
+}
+
+
+template <typename Volume>
+std::size_t cull_list(const Frustum& frustum, const Volume* volumes, std::size_t count,
+                      std::uint32_t* indices) {
+    std::size_t n = 0;
+    cull_volumes(frustum, volumes, count, [indices, &n](std::size_t i, bool v) {
+        // Write unconditionally to avoid branching on the visibility
+        indices[n] = (std::uint32_t)i;
+        n += v ? 1 : 0;
+    });
+
+    if (simd::is_verifying() && count > 0) {
+        std::vector<float> result(count, 0.0f);
+        for (std::size_t i = 0; i < n; ++i) {
+            result[indices[i]] = 1.0f;
+        }
+        verify(frustum, volumes, result);
+    }
+    return n;
+}
+
+
+}
+
+
+namespace jelly {
+
+
+void cull(const Frustum& frustum, const Sphere* spheres, std::size_t count, std::uint8_t* visible) {
+    cull_mask(frustum, spheres, count, visible);
+}
+
+
+void cull(const Frustum& frustum, const Aabb* boxes, std::size_t count, std::uint8_t* visible) {
+    cull_mask(frustum, boxes, count, visible);
+}
+
+
+std::size_t cull_indices(const Frustum& frustum, const Sphere* spheres, std::size_t count,
+                         std::uint32_t* indices) {
+    return cull_list(frustum, spheres, count, indices);
+}
+
+
+std::size_t cull_indices(const Frustum& frustum, const Aabb* boxes, std::size_t count,
+                         std::uint32_t* indices) {
+    return cull_list(frustum, boxes, count, indices);
+}
+
+
+}
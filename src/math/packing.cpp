@@ -0,0 +1,276 @@
+#include <jelly/math/packing.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include <jelly/math/simd_ops.hpp>
+
+// Without F16C enabled for the compiler, x86 builds check for it at run time
+#if defined(__F16C__) && !defined(JELLY_SIMD_SCALAR)
+#define JELLY_F16C
+#elif !defined(JELLY_SIMD_SCALAR) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define JELLY_F16C
+#define JELLY_F16C_DISPATCH
+#endif
+
+#if defined(JELLY_F16C)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+
+using namespace jelly;
+
+#if !defined(JELLY_SIMD_SCALAR)
+using namespace jelly::simd;
+#endif
+
+static_assert(sizeof(Vec3) == 3*sizeof(float), "Vec3 arrays must be tightly packed");
+
+
+std::uint16_t half_bits(float f) {
+    // Rebias the exponent and round the mantissa to nearest even, see
+    // F. Giesen, "float->half variants"
+    const std::uint32_t F32_INFINITY = 255u << 23;
+    const std::uint32_t F16_OVERFLOW = (127u + 16u) << 23;
+    const std::uint32_t DENORMAL_MAGIC = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    std::uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    std::uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+
+    std::uint16_t h;
+    if (u >= F16_OVERFLOW) {
+        // Infinities and overflows become infinities, NaNs quiet NaNs
+        h = u > F32_INFINITY ? 0x7e00 : 0x7c00;
+    }
+    else if (u < (113u << 23)) {
+        // Denormals, rounded by the float addition
+        float magic;
+        std::memcpy(&magic, &DENORMAL_MAGIC, sizeof(magic));
+        float a;
+        std::memcpy(&a, &u, sizeof(a));
+        a += magic;
+        std::memcpy(&u, &a, sizeof(u));
+        h = (std::uint16_t)(u - DENORMAL_MAGIC);
+    }
+    else {
+        std::uint32_t odd = (u >> 13) & 1u;
+        u += ((15u - 127u) << 23) + 0xfffu + odd;
+        h = (std::uint16_t)(u >> 13);
+    }
+    return h | (std::uint16_t)(sign >> 16);
+}
+
+
+inline float clamp(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+
+template <typename Int>
+void octahedral_scalar(const Vec3& n, float scale, Int* out) {
+    Vec2 e = encode_octahedral(n);
+    out[0] = (Int)std::lrint(clamp(e.x(), -1.0f, 1.0f) * scale);
+    out[1] = (Int)std::lrint(clamp(e.y(), -1.0f, 1.0f) * scale);
+}
+
+
+#if defined(JELLY_F16C)
+
+/**
+ * Converts the floats to halves 4 at a time.
+ *
+ * \returns
+ *     The number of floats converted, a multiple of 4.
+ */
+#if defined(JELLY_F16C_DISPATCH)
+__attribute__((target("f16c")))
+#endif
+std::size_t pack_half_f16c(const float* in, std::uint16_t* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i h = _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storel_epi64((__m128i*)(out + i), h);
+    }
+    return i;
+}
+
+
+bool has_f16c() {
+#if defined(JELLY_F16C_DISPATCH)
+    static const bool supported = __builtin_cpu_supports("f16c");
+    return supported;
+#else
+    return true;
+#endif
+}
+
+#endif
+
+
+#if !defined(JELLY_SIMD_SCALAR)
+
+/**
+ * Encodes normals i to i + 3, in the same order of operations as
+ * encode_octahedral().
+ */
+template <typename Int>
+void octahedral4(const Vec3* normals, float scale, Int* out) {
+    f32x4 x, y, z;
+    load3x4(normals[0].data(), x, y, z);
+    f32x4 zero = set1(0.0f);
+    f32x4 one = set1(1.0f);
+    f32x4 minus_one = set1(-1.0f);
+
+    f32x4 inv = div(one, add(add(abs(x), abs(y)), abs(z)));
+    f32x4 px = mul(x, inv);
+    f32x4 py = mul(y, inv);
+
+    // Unfold the lower half where z < 0
+    f32x4 wx = mul(sub(one, abs(py)), select_positive(sub(zero, px), minus_one, one));
+    f32x4 wy = mul(sub(one, abs(px)), select_positive(sub(zero, py), minus_one, one));
+    f32x4 lower = sub(zero, z);
+    px = select_positive(lower, wx, px);
+    py = select_positive(lower, wy, py);
+
+    f32x4 s = set1(scale);
+    std::int32_t qx[4];
+    std::int32_t qy[4];
+    store_rounded(qx, mul(max(min(px, one), minus_one), s));
+    store_rounded(qy, mul(max(min(py, one), minus_one), s));
+    for (unsigned int k = 0; k < 4; ++k) {
+        out[2*k] = (Int)qx[k];
+        out[2*k + 1] = (Int)qy[k];
+    }
+}
+
+#endif
+
+
+template <typename Int>
+void pack_octahedral_normals(const Vec3* normals, Int* out, std::size_t count, float scale) {
+    std::size_t i = 0;
+#if !defined(JELLY_SIMD_SCALAR)
+    for (; i + 4 <= count; i += 4) {
+        octahedral4(normals + i, scale, out + 2*i);
+    }
+#endif
+    for (; i < count; ++i) {
+        octahedral_scalar(normals[i], scale, out + 2*i);
+    }
+
+    if (simd::is_verifying() && count > 0) {
+        std::vector<float> result(out, out + 2*count);
+        std::vector<float> reference(2*count);
+        for (std::size_t j = 0; j < count; ++j) {
+            Int e[2];
+            octahedral_scalar(normals[j], scale, e);
+            reference[2*j] = e[0];
+            reference[2*j + 1] = e[1];
+        }
+        simd::_verify("pack_octahedral", result.data(), reference.data(), (unsigned int)result.size());
+    }
+}
+
+
+}
+
+
+namespace jelly {
+
+
+void pack_half(const float* in, std::uint16_t* out, std::size_t count) {
+    std::size_t i = 0;
+#if defined(JELLY_F16C)
+    if (has_f16c()) {
+        i = pack_half_f16c(in, out, count);
+    }
+#elif defined(JELLY_SIMD_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = half_bits(in[i]);
+    }
+
+    if (simd::is_verifying() && count > 0) {
+        // Compare the decoded values, as NaN payloads may differ
+        std::vector<float> result(count);
+        std::vector<float> reference(count);
+        for (std::size_t j = 0; j < count; ++j) {
+            result[j] = unpack_half(out[j]);
+            reference[j] = unpack_half(half_bits(in[j]));
+        }
+        simd::_verify("pack_half", result.data(), reference.data(), (unsigned int)count);
+    }
+}
+
+
+float unpack_half(std::uint16_t h) {
+    std::uint32_t sign = (std::uint32_t)(h & 0x8000u) << 16;
+    std::uint32_t exponent = (h >> 10) & 0x1fu;
+    std::uint32_t mantissa = h & 0x3ffu;
+
+    std::uint32_t u;
+    if (exponent == 0) {
+        float f = std::ldexp((float)mantissa, -24);
+        std::memcpy(&u, &f, sizeof(u));
+        u |= sign;
+    }
+    else if (exponent == 31) {
+        u = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else {
+        u = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+    }
+
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+
+void pack_unorm16(const float* in, std::uint16_t* out, std::size_t count) {
+    std::size_t i = 0;
+#if !defined(JELLY_SIMD_SCALAR)
+    f32x4 zero = set1(0.0f);
+    f32x4 one = set1(1.0f);
+    f32x4 scale = set1(65535.0f);
+    for (; i + 4 <= count; i += 4) {
+        std::int32_t q[4];
+        store_rounded(q, mul(max(min(load(in + i), one), zero), scale));
+        for (unsigned int k = 0; k < 4; ++k) {
+            out[i + k] = (std::uint16_t)q[k];
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = (std::uint16_t)std::lrint(clamp(in[i], 0.0f, 1.0f) * 65535.0f);
+    }
+
+    if (simd::is_verifying() && count > 0) {
+        std::vector<float> result(out, out + count);
+        std::vector<float> reference(count);
+        for (std::size_t j = 0; j < count; ++j) {
+            reference[j] = std::lrint(clamp(in[j], 0.0f, 1.0f) * 65535.0f);
+        }
+        simd::_verify("pack_unorm16", result.data(), reference.data(), (unsigned int)count);
+    }
+}
+
+
+void pack_octahedral(const Vec3* normals, std::int16_t* out, std::size_t count) {
+    pack_octahedral_normals(normals, out, count, 32767.0f);
+}
+
+
+void pack_octahedral(const Vec3* normals, std::int8_t* out, std::size_t count) {
+    pack_octahedral_normals(normals, out, count, 127.0f);
+}
+
+
+}
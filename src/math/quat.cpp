@@ -0,0 +1,189 @@
+#include <jelly/math/quat.hpp>
+
+#include <vector>
+
+#include <jelly/math/simd_ops.hpp>
+
+namespace {
+
+
+using namespace jelly;
+
+#if !defined(JELLY_SIMD_SCALAR)
+using namespace jelly::simd;
+#endif
+
+static_assert(sizeof(Quat) == 4*sizeof(float), "Quat arrays must be tightly packed");
+
+
+#if !defined(JELLY_SIMD_SCALAR)
+
+/*
+ * Each kernel interpolates 4 quaternions, with their components in separate
+ * registers, in the same order of operations as the scalar templates.
+ */
+
+inline f32x4 dot4(const f32x4* a, const f32x4* b) {
+    return madd(a[3], b[3], madd(a[2], b[2], madd(a[1], b[1], mul(a[0], b[0]))));
+}
+
+
+inline f32x4 negate(f32x4 v) {
+    return mul(v, set1(-1.0f));
+}
+
+
+void simd_nlerp(const f32x4* a, const f32x4* b, f32x4 t, f32x4* o) {
+    f32x4 tb = select_positive(negate(dot4(a, b)), negate(t), t);
+    f32x4 s = sub(set1(1.0f), t);
+    for (unsigned int c = 0; c < 4; ++c) {
+        o[c] = madd(tb, b[c], mul(s, a[c]));
+    }
+    f32x4 inv = rsqrt(dot4(o, o));
+    for (unsigned int c = 0; c < 4; ++c) {
+        o[c] = mul(inv, o[c]);
+    }
+}
+
+
+void simd_slerp(const f32x4* a, const f32x4* b, f32x4 t, f32x4* o) {
+    const float mu = 1.917f;
+    f32x4 one = set1(1.0f);
+    f32x4 cs = dot4(a, b);
+    f32x4 sign = select_positive(negate(cs), set1(-1.0f), one);
+    cs = mul(cs, sign);
+
+    f32x4 xm1 = sub(cs, one);
+    f32x4 s = sub(one, t);
+    f32x4 t2 = mul(t, t);
+    f32x4 s2 = mul(s, s);
+    f32x4 ft = one;
+    f32x4 fs = one;
+    for (int i = 15; i >= 0; --i) {
+        float u = 1.0f / float((i + 1) * (2*i + 3));
+        float v = float(i + 1) / float(2*i + 3);
+        if (i == 15) {
+            u *= mu;
+            v *= mu;
+        }
+        f32x4 ui = set1(u);
+        f32x4 vi = set1(v);
+        ft = add(one, mul(mul(sub(mul(ui, t2), vi), xm1), ft));
+        fs = add(one, mul(mul(sub(mul(ui, s2), vi), xm1), fs));
+    }
+
+    f32x4 ca = mul(s, fs);
+    f32x4 cb = mul(mul(sign, t), ft);
+    for (unsigned int c = 0; c < 4; ++c) {
+        o[c] = madd(cb, b[c], mul(ca, a[c]));
+    }
+}
+
+#endif
+
+
+struct NlerpOp {
+
+    static const char* name() { return "nlerp"; }
+
+    Quat operator()(const Quat& a, const Quat& b, float t) const
+    {
+        return jelly::nlerp(a, b, t);
+    }
+
+#if !defined(JELLY_SIMD_SCALAR)
+    void operator()(const f32x4* a, const f32x4* b, f32x4 t, f32x4* o) const
+    {
+        simd_nlerp(a, b, t, o);
+    }
+#endif
+
+};
+
+
+struct SlerpOp {
+
+    static const char* name() { return "slerp"; }
+
+    Quat operator()(const Quat& a, const Quat& b, float t) const
+    {
+        return jelly::slerp(a, b, t);
+    }
+
+#if !defined(JELLY_SIMD_SCALAR)
+    void operator()(const f32x4* a, const f32x4* b, f32x4 t, f32x4* o) const
+    {
+        simd_slerp(a, b, t, o);
+    }
+#endif
+
+};
+
+
+/**
+ * Interpolates count quaternions, by t[i] or by t[0] for all when uniform.
+ */
+template <typename Op>
+void batch(const Op& op, const Quat* a, const Quat* b, const float* t, bool uniform,
+           Quat* out, std::size_t count) {
+    std::vector<Quat> input;
+    std::vector<float> times;
+    if (simd::is_verifying()) {
+        input.assign(a, a + count);
+        input.insert(input.end(), b, b + count);
+        times.assign(t, t + (uniform ? 1 : count));
+    }
+
+    std::size_t i = 0;
+#if !defined(JELLY_SIMD_SCALAR)
+    for (; i + 4 <= count; i += 4) {
+        f32x4 qa[4];
+        f32x4 qb[4];
+        f32x4 qo[4];
+        load4x4(a[i].data(), qa[0], qa[1], qa[2], qa[3]);
+        load4x4(b[i].data(), qb[0], qb[1], qb[2], qb[3]);
+        op(qa, qb, uniform ? set1(t[0]) : load(t + i), qo);
+        store4x4(out[i].data(), qo[0], qo[1], qo[2], qo[3]);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = op(a[i], b[i], t[uniform ? 0 : i]);
+    }
+
+    if (simd::is_verifying() && count > 0) {
+        std::vector<Quat> reference(count);
+        for (std::size_t j = 0; j < count; ++j) {
+            reference[j] = op(input[j], input[count + j], times[uniform ? 0 : j]);
+        }
+        simd::_verify(Op::name(), out[0].data(), reference[0].data(), (unsigned int)(4 * count));
+    }
+}
+
+
+}
+
+
+namespace jelly {
+
+
+void nlerp(const Quat* a, const Quat* b, float t, Quat* out, std::size_t count) {
+    batch(NlerpOp(), a, b, &t, true, out, count);
+}
+
+
+void nlerp(const Quat* a, const Quat* b, const float* t, Quat* out, std::size_t count) {
+    batch(NlerpOp(), a, b, t, false, out, count);
+}
+
+
+void slerp(const Quat* a, const Quat* b, float t, Quat* out, std::size_t count) {
+    batch(SlerpOp(), a, b, &t, true, out, count);
+}
+
+
+void slerp(const Quat* a, const Quat* b, const float* t, Quat* out, std::size_t count) {
+    batch(SlerpOp(), a, b, t, false, out, count);
+}
+
+
+}
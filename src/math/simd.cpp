@@ -0,0 +1,66 @@
+#include <jelly/math/simd_ops.hpp>
+
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+
+unsigned int mismatches = 0;
+
+
+}
+
+
+namespace jelly {
+
+namespace simd {
+
+
+bool _verifying = false;
+
+
+const char* backend() {
+#if defined(JELLY_SIMD_AVX)
+    return "AVX";
+#elif defined(JELLY_SIMD_SSE2)
+    return "SSE2";
+#elif defined(JELLY_SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+
+void set_verify(bool enabled) {
+    if (enabled && !_verifying) {
+        mismatches = 0;
+    }
+    _verifying = enabled;
+}
+
+
+unsigned int get_mismatch_count() {
+    return mismatches;
+}
+
+
+void _verify(const char* kernel, const float* result, const float* reference, unsigned int n) {
+    for (unsigned int i = 0; i < n; ++i) {
+        // Fused and reordered operations only cause rounding differences
+        float tolerance = 1e-5f * fmaxf(1.0f, fabsf(reference[i]));
+        if (result[i] != reference[i] && !(fabsf(result[i] - reference[i]) <= tolerance)
+                && !(std::isnan(result[i]) && std::isnan(reference[i]))) {
+            mismatches += 1;
+            std::cerr << "Warning: " << backend() << " " << kernel << " differs from scalar at "
+                << i << ": " << result[i] << " != " << reference[i] << std::endl;
+            return;
+        }
+    }
+}
+
+
+}
+
+}
@@ -0,0 +1,479 @@
+#include <jelly/math/transform.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <jelly/math/simd_ops.hpp>
+
+namespace {
+
+
+using namespace jelly;
+
+#if !defined(JELLY_SIMD_SCALAR)
+using namespace jelly::simd;
+#endif
+
+static_assert(sizeof(Vec3) == 3*sizeof(float), "Vec3 arrays must be tightly packed");
+static_assert(sizeof(Vec4) == 4*sizeof(float), "Vec4 arrays must be tightly packed");
+
+// Below this many elements per thread, starting a thread costs more than the
+// transform itself
+const std::size_t MIN_THREAD_ELEMENTS = 32768;
+
+unsigned int thread_limit = 0;
+
+
+/**
+ * Calls kernel(begin, end) over [0, count), split across threads when large
+ * enough. The parts start on multiples of 4 elements.
+ */
+template <typename Kernel>
+void parallel_for(std::size_t count, const Kernel& kernel) {
+    std::size_t threads = std::min<std::size_t>(get_transform_threads(), count / MIN_THREAD_ELEMENTS);
+    if (threads <= 1) {
+        kernel(0, count);
+        return;
+    }
+
+    std::size_t part = ((count + threads - 1) / threads + 3) & ~std::size_t(3);
+    std::vector<std::thread> workers;
+    for (std::size_t begin = part; begin < count; begin += part) {
+        workers.emplace_back(kernel, begin, std::min(count, begin + part));
+    }
+    kernel(0, std::min(count, part));
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+
+#if !defined(JELLY_SIMD_SCALAR)
+
+/**
+ * Returns row r of m applied to (x, y, z, 0) as the scalar templates order it.
+ */
+inline f32x4 row3(const f32x4* r, f32x4 x, f32x4 y, f32x4 z) {
+    return madd(r[2], z, madd(r[1], y, mul(r[0], x)));
+}
+
+#endif
+
+
+/*
+ * Each operation transforms a single vector with the scalar templates, and 4
+ * vectors with the SIMD functions when available.
+ */
+
+struct PointOp {
+
+    static const char* name() { return "transform_points"; }
+
+    explicit PointOp(const Mat4& m) : m(m)
+    {
+#if !defined(JELLY_SIMD_SCALAR)
+        for (unsigned int r = 0; r < 3; ++r) {
+            for (unsigned int c = 0; c < 4; ++c) {
+                rows[r][c] = set1(m(r, c));
+            }
+        }
+#endif
+    }
+
+    Vec3 operator()(const Vec3& p) const
+    {
+        return detail::transform(m, Vec4(p, 1.0f)).xyz();
+    }
+
+#if !defined(JELLY_SIMD_SCALAR)
+    void operator()(f32x4& x, f32x4& y, f32x4& z) const
+    {
+        f32x4 rx = add(row3(rows[0], x, y, z), rows[0][3]);
+        f32x4 ry = add(row3(rows[1], x, y, z), rows[1][3]);
+        f32x4 rz = add(row3(rows[2], x, y, z), rows[2][3]);
+        x = rx;
+        y = ry;
+        z = rz;
+    }
+
+    f32x4 rows[3][4];
+#endif
+
+    Mat4 m;
+
+};
+
+
+struct DirectionOp {
+
+    static const char* name() { return "transform_directions"; }
+
+    explicit DirectionOp(const Mat4& m) : m(topleft(m))
+    {
+#if !defined(JELLY_SIMD_SCALAR)
+        for (unsigned int r = 0; r < 3; ++r) {
+            for (unsigned int c = 0; c < 3; ++c) {
+                rows[r][c] = set1(m(r, c));
+            }
+        }
+#endif
+    }
+
+    Vec3 operator()(const Vec3& d) const
+    {
+        return detail::transform(m, d);
+    }
+
+#if !defined(JELLY_SIMD_SCALAR)
+    void operator()(f32x4& x, f32x4& y, f32x4& z) const
+    {
+        f32x4 rx = row3(rows[0], x, y, z);
+        f32x4 ry = row3(rows[1], x, y, z);
+        f32x4 rz = row3(rows[2], x, y, z);
+        x = rx;
+        y = ry;
+        z = rz;
+    }
+
+    f32x4 rows[3][3];
+#endif
+
+    Mat3 m;
+
+};
+
+
+struct NormalOp {
+
+    static const char* name() { return "transform_normals"; }
+
+    explicit NormalOp(const Mat4& m) : directions(Mat4(normal_matrix(m))) {}
+
+    Vec3 operator()(const Vec3& n) const
+    {
+        return normalize(directions(n));
+    }
+
+#if !defined(JELLY_SIMD_SCALAR)
+    void operator()(f32x4& x, f32x4& y, f32x4& z) const
+    {
+        directions(x, y, z);
+        f32x4 inv = rsqrt(madd(z, z, madd(y, y, mul(x, x))));
+        x = mul(inv, x);
+        y = mul(inv, y);
+        z = mul(inv, z);
+    }
+#endif
+
+    DirectionOp directions;
+
+};
+
+
+struct ProjectOp {
+
+    static const char* name() { return "project_points"; }
+
+    ProjectOp(const Mat4& m, const Vec4& viewport) :
+        m(m),
+        scale(0.5f * viewport.z(), 0.5f * viewport.w(), 0.5f),
+        offset(viewport.x() + scale.x(), viewport.y() + scale.y(), 0.5f)
+    {
+#if !defined(JELLY_SIMD_SCALAR)
+        for (unsigned int r = 0; r < 4; ++r) {
+            for (unsigned int c = 0; c < 4; ++c) {
+                rows[r][c] = set1(m(r, c));
+            }
+        }
+#endif
+    }
+
+    Vec3 operator()(const Vec3& p) const
+    {
+        Vec4 clip = detail::transform(m, Vec4(p, 1.0f));
+        if (!(clip.w() > 0.0f)) {
+            return Vec3(std::numeric_limits<float>::quiet_NaN());
+        }
+        float inv = 1.0f / clip.w();
+        return Vec3(
+            (clip.x() * inv) * scale.x() + offset.x(),
+            (clip.y() * inv) * scale.y() + offset.y(),
+            (clip.z() * inv) * scale.z() + offset.z()
+        );
+    }
+
+#if !defined(JELLY_SIMD_SCALAR)
+    void operator()(f32x4& x, f32x4& y, f32x4& z) const
+    {
+        f32x4 w = add(row3(rows[3], x, y, z), rows[3][3]);
+        f32x4 inv = div(set1(1.0f), w);
+        f32x4 nan = set1(std::numeric_limits<float>::quiet_NaN());
+        f32x4 rx = add(row3(rows[0], x, y, z), rows[0][3]);
+        f32x4 ry = add(row3(rows[1], x, y, z), rows[1][3]);
+        f32x4 rz = add(row3(rows[2], x, y, z), rows[2][3]);
+        x = select_positive(w, madd(mul(rx, inv), set1(scale.x()), set1(offset.x())), nan);
+        y = select_positive(w, madd(mul(ry, inv), set1(scale.y()), set1(offset.y())), nan);
+        z = select_positive(w, madd(mul(rz, inv), set1(scale.z()), set1(offset.z())), nan);
+    }
+
+    f32x4 rows[4][4];
+#endif
+
+    Mat4 m;
+    Vec3 scale;
+    Vec3 offset;
+
+};
+
+
+template <typename Op>
+void run(const Op& op, const Vec3* in, Vec3* out, std::size_t begin, std::size_t end) {
+    std::size_t i = begin;
+#if !defined(JELLY_SIMD_SCALAR)
+    for (; i + 4 <= end; i += 4) {
+        f32x4 x, y, z;
+        load3x4(in[i].data(), x, y, z);
+        op(x, y, z);
+        store3x4(out[i].data(), x, y, z);
+    }
+#endif
+    for (; i < end; ++i) {
+        out[i] = op(in[i]);
+    }
+}
+
+
+template <typename Op>
+void run(const Op& op, const float* const* in, float* const* out, std::size_t begin, std::size_t end) {
+    std::size_t i = begin;
+#if !defined(JELLY_SIMD_SCALAR)
+    for (; i + 4 <= end; i += 4) {
+        f32x4 x = load(in[0] + i);
+        f32x4 y = load(in[1] + i);
+        f32x4 z = load(in[2] + i);
+        op(x, y, z);
+        store(out[0] + i, x);
+        store(out[1] + i, y);
+        store(out[2] + i, z);
+    }
+#endif
+    for (; i < end; ++i) {
+        Vec3 r = op(Vec3(in[0][i], in[1][i], in[2][i]));
+        out[0][i] = r.x();
+        out[1][i] = r.y();
+        out[2][i] = r.z();
+    }
+}
+
+
+/**
+ * Compares the results of a batch to the scalar operation on a copy of the
+ * input.
+ */
+template <typename Op>
+void verify(const Op& op, const std::vector<Vec3>& in, const std::vector<Vec3>& out) {
+    std::vector<Vec3> reference(in.size());
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        reference[i] = op(in[i]);
+    }
+    simd::_verify(Op::name(), out[0].data(), reference[0].data(), (unsigned int)(3 * in.size()));
+}
+
+
+template <typename Op>
+void batch(const Op& op, const Vec3* in, Vec3* out, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    std::vector<Vec3> input;
+    if (simd::is_verifying()) {
+        input.assign(in, in + count);
+    }
+
+    parallel_for(count, [&](std::size_t begin, std::size_t end) {
+        run(op, in, out, begin, end);
+    });
+
+    if (simd::is_verifying()) {
+        verify(op, input, std::vector<Vec3>(out, out + count));
+    }
+}
+
+
+template <typename Op>
+void batch(const Op& op, const float* x, const float* y, const float* z,
+           float* out_x, float* out_y, float* out_z, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    std::vector<Vec3> input;
+    if (simd::is_verifying()) {
+        input.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            input[i] = Vec3(x[i], y[i], z[i]);
+        }
+    }
+
+    const float* const in[] = {x, y, z};
+    float* const out[] = {out_x, out_y, out_z};
+    parallel_for(count, [&](std::size_t begin, std::size_t end) {
+        run(op, in, out, begin, end);
+    });
+
+    if (simd::is_verifying()) {
+        std::vector<Vec3> output(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            output[i] = Vec3(out_x[i], out_y[i], out_z[i]);
+        }
+        verify(op, input, output);
+    }
+}
+
+
+#if defined(JELLY_SIMD_AVX)
+
+void run_homogeneous(const Mat4& m, const Vec4* in, Vec4* out, std::size_t begin, std::size_t end) {
+    // Transforms two vectors per iteration, as the Mat4 product does with
+    // columns
+    const float* md = m.data();
+    __m256 c0 = _mm256_broadcast_ps((const __m128*)(md + 0));
+    __m256 c1 = _mm256_broadcast_ps((const __m128*)(md + 4));
+    __m256 c2 = _mm256_broadcast_ps((const __m128*)(md + 8));
+    __m256 c3 = _mm256_broadcast_ps((const __m128*)(md + 12));
+
+    std::size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        __m256 v = _mm256_loadu_ps(in[i].data());
+        __m256 r = _mm256_mul_ps(c0, _mm256_permute_ps(v, 0x00));
+        r = _mm256_add_ps(r, _mm256_mul_ps(c1, _mm256_permute_ps(v, 0x55)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(c2, _mm256_permute_ps(v, 0xAA)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(c3, _mm256_permute_ps(v, 0xFF)));
+        _mm256_storeu_ps(out[i].data(), r);
+    }
+    for (; i < end; ++i) {
+        out[i] = detail::transform(m, in[i]);
+    }
+}
+
+#elif !defined(JELLY_SIMD_SCALAR)
+
+void run_homogeneous(const Mat4& m, const Vec4* in, Vec4* out, std::size_t begin, std::size_t end) {
+    const float* md = m.data();
+    f32x4 c0 = load(md + 0);
+    f32x4 c1 = load(md + 4);
+    f32x4 c2 = load(md + 8);
+    f32x4 c3 = load(md + 12);
+
+    for (std::size_t i = begin; i < end; ++i) {
+        const float* v = in[i].data();
+        f32x4 r = mul(c0, set1(v[0]));
+        r = madd(c1, set1(v[1]), r);
+        r = madd(c2, set1(v[2]), r);
+        r = madd(c3, set1(v[3]), r);
+        store_aligned(out[i].data(), r);
+    }
+}
+
+#else
+
+void run_homogeneous(const Mat4& m, const Vec4* in, Vec4* out, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        out[i] = detail::transform(m, in[i]);
+    }
+}
+
+#endif
+
+
+}
+
+
+namespace jelly {
+
+
+void transform_points(const Mat4& m, const Vec3* points, Vec3* out, std::size_t count) {
+    batch(PointOp(m), points, out, count);
+}
+
+
+void transform_points(const Mat4& m, const float* x, const float* y, const float* z,
+                      float* out_x, float* out_y, float* out_z, std::size_t count) {
+    batch(PointOp(m), x, y, z, out_x, out_y, out_z, count);
+}
+
+
+void transform_points(const Mat4& m, const Vec4* points, Vec4* out, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    std::vector<Vec4> input;
+    if (simd::is_verifying()) {
+        input.assign(points, points + count);
+    }
+
+    parallel_for(count, [&](std::size_t begin, std::size_t end) {
+        run_homogeneous(m, points, out, begin, end);
+    });
+
+    if (simd::is_verifying()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            input[i] = detail::transform(m, input[i]);
+        }
+        simd::_verify("transform_points", out[0].data(), input[0].data(), (unsigned int)(4 * count));
+    }
+}
+
+
+void transform_directions(const Mat4& m, const Vec3* directions, Vec3* out, std::size_t count) {
+    batch(DirectionOp(m), directions, out, count);
+}
+
+
+void transform_directions(const Mat4& m, const float* x, const float* y, const float* z,
+                          float* out_x, float* out_y, float* out_z, std::size_t count) {
+    batch(DirectionOp(m), x, y, z, out_x, out_y, out_z, count);
+}
+
+
+void transform_normals(const Mat4& m, const Vec3* normals, Vec3* out, std::size_t count) {
+    batch(NormalOp(m), normals, out, count);
+}
+
+
+void transform_normals(const Mat4& m, const float* x, const float* y, const float* z,
+                       float* out_x, float* out_y, float* out_z, std::size_t count) {
+    batch(NormalOp(m), x, y, z, out_x, out_y, out_z, count);
+}
+
+
+void project_points(const Mat4& m, const Vec4& viewport, const Vec3* points, Vec3* out,
+                    std::size_t count) {
+    batch(ProjectOp(m, viewport), points, out, count);
+}
+
+
+void project_points(const Mat4& m, const Vec4& viewport, const float* x, const float* y,
+                    const float* z, float* out_x, float* out_y, float* out_z, std::size_t count) {
+    batch(ProjectOp(m, viewport), x, y, z, out_x, out_y, out_z, count);
+}
+
+
+void set_transform_threads(unsigned int count) {
+    thread_limit = count;
+}
+
+
+unsigned int get_transform_threads() {
+    if (thread_limit > 0) {
+        return thread_limit;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+}
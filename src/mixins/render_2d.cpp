@@ -4,141 +4,116 @@
 #include <jelly/gl/context.hpp>
 #include <jelly/gl/mesh.hpp>
 #include <jelly/gl/shader.hpp>
+#include <jelly/gl/shape_batch.hpp>
 
 using namespace jelly;
 
-const std::string BLIT_VS = R"(
+
+const std::string SHAPE_VS = R"(
     #version 330
 
     layout (location = 0) in vec3 v_Position;
-    layout (location = 1) in vec3 v_Normal;
-    layout (location = 2) in vec2 v_UV;
-
-    uniform mat4 u_Projection;
-    uniform vec4 u_Rectangle;
 
-    out vec2 o_UV;
+    layout (location = 3) in vec4 i_Rectangle;
+    layout (location = 4) in vec4 i_Color;
+    layout (location = 5) in float i_Stroke;
+    layout (location = 6) in float i_Radius;
+    layout (location = 7) in int i_Type;
+
+    layout (std140) uniform FrameGlobals {
+        mat4 u_Projection;
+        mat4 u_View;
+        vec2 u_ViewportSize;
+        float u_Time;
+    };
+
+    out vec2 o_Local;
+    flat out vec4 o_ShapeColor;
+    flat out vec2 o_HalfSize;
+    flat out float o_Stroke;
+    flat out float o_Radius;
+    flat out int o_Type;
 
     void main() {
-        o_UV = v_UV;
-
-        vec3 scale = vec3(
-            u_Rectangle.z - u_Rectangle.x,
-            u_Rectangle.w - u_Rectangle.y,
-            1.0
-        );
-        vec3 offset = vec3(u_Rectangle.xy, 0.0);
-        gl_Position = u_Projection * vec4(scale * v_Position + offset, 1.0);
+        o_ShapeColor = i_Color;
+        o_HalfSize = 0.5 * abs(i_Rectangle.zw - i_Rectangle.xy);
+        o_Stroke = i_Stroke;
+        o_Radius = min(i_Radius, min(o_HalfSize.x, o_HalfSize.y));
+        o_Type = i_Type;
+
+        // Pad the quad by a pixel to leave room for the antialiased edge
+        vec2 center = 0.5 * (i_Rectangle.xy + i_Rectangle.zw);
+        o_Local = (2.0 * v_Position.xy - 1.0) * (o_HalfSize + 1.0);
+        gl_Position = u_Projection * u_View * vec4(center + o_Local, 0.0, 1.0);
     }
 )";
 
-const std::string FILL_RECTANGLE_FS = R"(
+const std::string SHAPE_FS = R"(
     #version 330
 
-    uniform vec4 u_Color;
+    in vec2 o_Local;
+    flat in vec4 o_ShapeColor;
+    flat in vec2 o_HalfSize;
+    flat in float o_Stroke;
+    flat in float o_Radius;
+    flat in int o_Type;
 
     out vec4 o_Color;
 
-    void main() {
-        o_Color = u_Color;
+    // Signed distance in pixels to a rectangle with rounded corners
+    float rectangle_distance(vec2 p, vec2 b, float r) {
+        vec2 q = abs(p) - b + r;
+        return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - r;
     }
-)";
-
-const std::string DRAW_RECTANGLE_FS = R"(
-    #version 330
 
-    in vec2 o_UV;
-
-    uniform vec4 u_Color;
-    uniform vec2 u_PixelSize;
-    uniform int u_PixelStroke;
-
-    out vec4 o_Color;
-
-    void main() {
-        vec2 coords = u_PixelSize * o_UV;
-        if (
-            coords.x > u_PixelStroke &&
-            coords.x < u_PixelSize.x - u_PixelStroke &&
-            coords.y > u_PixelStroke &&
-            coords.y < u_PixelSize.y - u_PixelStroke
-        ) {
-            discard;
-        }
-        o_Color = u_Color;
+    // Approximate signed distance in pixels to an axis-aligned ellipse
+    float ellipse_distance(vec2 p, vec2 b) {
+        float k0 = length(p / b);
+        float k1 = length(p / (b * b));
+        return k1 > 0.0 ? k0 * (k0 - 1.0) / k1 : -min(b.x, b.y);
     }
-)";
-
-const std::string FILL_ELLIPSE_FS = R"(
-    #version 330
-
-    in vec2 o_UV;
-
-    uniform vec4 u_Color;
-
-    out vec4 o_Color;
 
     void main() {
-        vec2 v = 2 * o_UV - 1;
-        if (dot(v, v) > 1) {
-            discard;
-        }
-        o_Color = u_Color;
-    }
-)";
+        float d = o_Type == 1
+            ? ellipse_distance(o_Local, max(o_HalfSize, 0.5))
+            : rectangle_distance(o_Local, o_HalfSize, o_Radius);
 
-const std::string DRAW_ELLIPSE_FS = R"(
-    #version 330
-
-    in vec2 o_UV;
-
-    uniform vec4 u_Color;
-    uniform vec2 u_PixelSize;
-    uniform int  u_PixelStroke;
-
-    out vec4 o_Color;
-
-    void main() {
-        vec2 coords = u_PixelSize * o_UV;
-        vec2 v = 2 * o_UV - 1;
-        vec2 edge = normalize(v);
-        vec2 edge_coords = u_PixelSize * (edge + 1) * 0.5;
-        vec2 from_edge = coords - edge_coords;
-        float dist2 = dot(from_edge, from_edge);
-        if (dot(v, v) > 1) {
-            discard;
+        // Strokes are a band of the given width along the inside of the edge
+        if (o_Stroke > 0.0) {
+            d = abs(d + 0.5 * o_Stroke) - 0.5 * o_Stroke;
         }
-        if (dist2 > u_PixelStroke * u_PixelStroke) {
+
+        // Coverage only fades the edges when blending, so the padding of the
+        // quad outside the shape is discarded to keep it correct without
+        float coverage = clamp(0.5 - d, 0.0, 1.0);
+        if (coverage <= 0.0) {
             discard;
         }
-        o_Color = u_Color;
+        o_Color = vec4(o_ShapeColor.rgb, o_ShapeColor.a * coverage);
     }
 )";
 
 
 Render2DMixin::Render2DMixin(Sketch* sketch):
     _sketch(sketch),
+    _shape_shader(nullptr),
+    _quad_mesh(nullptr),
+    _batch(nullptr),
     _color(0.0, 0.0, 0.0, 1.0),
-    _stroke_size(1)
+    _stroke_size(1),
+    _frame_flush_count(0),
+    _frame_shape_count(0)
 {}
 
 
 Render2DMixin::~Render2DMixin() {
-    if (_fill_rectangle_shader) {
-        delete _fill_rectangle_shader;
-        _fill_rectangle_shader = nullptr;
+    if (_batch) {
+        delete _batch;
+        _batch = nullptr;
     }
-    if (_fill_ellipse_shader) {
-        delete _fill_ellipse_shader;
-        _fill_ellipse_shader = nullptr;
-    }
-    if (_draw_rectangle_shader) {
-        delete _draw_rectangle_shader;
-        _draw_rectangle_shader = nullptr;
-    }
-    if (_draw_ellipse_shader) {
-        delete _draw_ellipse_shader;
-        _draw_ellipse_shader = nullptr;
+    if (_shape_shader) {
+        delete _shape_shader;
+        _shape_shader = nullptr;
     }
     if (_quad_mesh) {
         delete _quad_mesh;
@@ -148,11 +123,23 @@ Render2DMixin::~Render2DMixin() {
 
 
 void Render2DMixin::init() {
-    _fill_rectangle_shader = new Shader(BLIT_VS, FILL_RECTANGLE_FS);
-    _draw_rectangle_shader = new Shader(BLIT_VS, DRAW_RECTANGLE_FS);
-    _fill_ellipse_shader = new Shader(BLIT_VS, FILL_ELLIPSE_FS);
-    _draw_ellipse_shader = new Shader(BLIT_VS, DRAW_ELLIPSE_FS);
+    _shape_shader = new Shader(SHAPE_VS, SHAPE_FS);
+    _shape_shader->set_uniform_block("FrameGlobals", Sketch::FRAME_GLOBALS_BINDING);
     _quad_mesh = Mesh::quad_mesh();
+    _batch = new ShapeBatch(*_quad_mesh);
+
+    // Pending shapes must be rendered before anything else touches the context
+    _sketch->jelly_context().set_on_flush([this](Context& c) {
+        this->_batch->flush(c);
+    });
+}
+
+
+void Render2DMixin::end_frame() {
+    _batch->flush(_sketch->jelly_context());
+    _frame_flush_count = _batch->get_flush_count();
+    _frame_shape_count = _batch->get_shape_count();
+    _batch->reset_counters();
 }
 
 
@@ -177,50 +164,41 @@ void Render2DMixin::set_stroke_size(int stroke) {
 
 
 void Render2DMixin::fill_rectangle(int x1, int y1, int x2, int y2) {
-    Context& c = _sketch->jelly_context();
-    c.activate_shader(*_fill_rectangle_shader);
-    _fill_rectangle_shader->set_uniform_vec4("u_Color", _color);
-    _fill_rectangle_shader->set_uniform_vec4("u_Rectangle", Vec4(x1, y1, x2, y2));
-    _fill_rectangle_shader->set_uniform_mat4("u_Projection", _sketch->projection_mat());
-    c.render_mesh(*_quad_mesh);
+    _push_shape({Vec4(x1, y1, x2, y2), _color, 0.0f, 0.0f, ShapeInstance::RECTANGLE});
 }
 
 
 void Render2DMixin::draw_rectangle(int x1, int y1, int x2, int y2) {
-    Context& c = _sketch->jelly_context();
-    c.activate_shader(*_draw_rectangle_shader);
-    _draw_rectangle_shader->set_uniform_vec4("u_Color", _color);
-    _draw_rectangle_shader->set_uniform_int("u_PixelStroke", _stroke_size);
-    _draw_rectangle_shader->set_uniform_vec2("u_PixelSize", Vec2(x2 - x1, y2 - y1));
-    _draw_rectangle_shader->set_uniform_vec4("u_Rectangle", Vec4(x1, y1, x2, y2));
-    _draw_rectangle_shader->set_uniform_mat4("u_Projection", _sketch->projection_mat());
-    c.render_mesh(*_quad_mesh);
+    _push_shape({Vec4(x1, y1, x2, y2), _color, (float)_stroke_size, 0.0f, ShapeInstance::RECTANGLE});
+}
+
+
+void Render2DMixin::fill_rounded_rectangle(int x1, int y1, int x2, int y2, int radius) {
+    _push_shape({Vec4(x1, y1, x2, y2), _color, 0.0f, (float)radius, ShapeInstance::RECTANGLE});
+}
+
+
+void Render2DMixin::draw_rounded_rectangle(int x1, int y1, int x2, int y2, int radius) {
+    _push_shape({Vec4(x1, y1, x2, y2), _color, (float)_stroke_size, (float)radius, ShapeInstance::RECTANGLE});
 }
 
 
 void Render2DMixin::fill_ellipse(int x, int y, int w, int h) {
-    Context& c = _sketch->jelly_context();
-    c.activate_shader(*_fill_ellipse_shader);
-    _fill_ellipse_shader->set_uniform_vec4("u_Color", _color);
-    _fill_ellipse_shader->set_uniform_vec4(
-        "u_Rectangle",
-        Vec4(x - w / 2, y - h / 2, x + w / 2, y + h / 2)
-    );
-    _fill_ellipse_shader->set_uniform_mat4("u_Projection", _sketch->projection_mat());
-    c.render_mesh(*_quad_mesh);
+    _push_shape({
+        Vec4(x - w / 2, y - h / 2, x + w / 2, y + h / 2),
+        _color, 0.0f, 0.0f, ShapeInstance::ELLIPSE
+    });
 }
 
 
 void Render2DMixin::draw_ellipse(int x, int y, int w, int h) {
-    Context& c = _sketch->jelly_context();
-    c.activate_shader(*_draw_ellipse_shader);
-    _draw_ellipse_shader->set_uniform_vec4("u_Color", _color);
-    _draw_ellipse_shader->set_uniform_int("u_PixelStroke", _stroke_size);
-    _draw_ellipse_shader->set_uniform_vec2("u_PixelSize", Vec2(w, h));
-    _draw_ellipse_shader->set_uniform_vec4(
-        "u_Rectangle",
-        Vec4(x - w / 2, y - h / 2, x + w / 2, y + h / 2)
-    );
-    _draw_ellipse_shader->set_uniform_mat4("u_Projection", _sketch->projection_mat());
-    c.render_mesh(*_quad_mesh);
+    _push_shape({
+        Vec4(x - w / 2, y - h / 2, x + w / 2, y + h / 2),
+        _color, (float)_stroke_size, 0.0f, ShapeInstance::ELLIPSE
+    });
+}
+
+
+void Render2DMixin::_push_shape(const ShapeInstance& shape) {
+    _batch->append(_sketch->jelly_context(), *_shape_shader, shape);
 }
@@ -2,17 +2,30 @@
 
 using namespace jelly;
 
+constexpr unsigned int Sketch::FRAME_GLOBALS_BINDING;
+
 Sketch::Sketch() :
     CanvasMixin(this),
     KeyboardMixin(this),
     MouseMixin(this),
-    Render2DMixin(this)
+    Render2DMixin(this),
+    _view(1.0f),
+    _time(0.0)
 {}
 
 void Sketch::run() {
     _window = std::make_shared<Window>("Jelly", 640, 480);
 
     _window->set_on_create([this](Window& w, Context& c) {
+        // create the frame globals before any mixin shaders use them
+        Std140Layout layout;
+        this->_projection_offset = layout.add_mat4();
+        this->_view_offset = layout.add_mat4();
+        this->_viewport_size_offset = layout.add_vec2();
+        this->_time_offset = layout.add_float();
+        this->_frame_globals.reset(new UniformBuffer(layout));
+        c.bind_uniform_buffer(*this->_frame_globals, FRAME_GLOBALS_BINDING);
+
         // first initialize mixins that require it
         this->MouseMixin::init();
         this->KeyboardMixin::init();
@@ -20,17 +33,49 @@ void Sketch::run() {
 
         // set the projection to orthographic by default
         Vec2 size = w.get_size();
-        this->_projection = Mat4::orthographic(
+        this->set_projection_mat(Mat4::orthographic(
             0.0f, size.x(), 0.0f, size.y(), -1.0f, 1.0f
-        );
+        ));
+        this->set_view_mat(Mat4(1.0f));
 
         this->init();
     });
 
     _window->set_on_draw([this](Window& w, Context& c, double d) {
+        // update the frame globals once per frame
+        this->_time += d;
+        this->_frame_globals->set_vec2(this->_viewport_size_offset, w.get_size());
+        this->_frame_globals->set_float(this->_time_offset, this->_time);
+        this->_upload_frame_globals();
+
         this->tick(d);
         this->draw();
+
+        // submit the queued draws and the shapes batched during the frame
+        this->_render_queue.submit(c);
+        this->Render2DMixin::end_frame();
     });
 
     _window->create_windowed();
 }
+
+void Sketch::set_projection_mat(const Mat4& projection) {
+    _projection = projection;
+    if (_frame_globals) {
+        _frame_globals->set_mat4(_projection_offset, _projection);
+        _upload_frame_globals();
+    }
+}
+
+void Sketch::set_view_mat(const Mat4& view) {
+    _view = view;
+    if (_frame_globals) {
+        _frame_globals->set_mat4(_view_offset, _view);
+        _upload_frame_globals();
+    }
+}
+
+void Sketch::_upload_frame_globals() {
+    jelly_context().flush();
+    _frame_globals->upload();
+}
@@ -161,12 +161,6 @@ void Window::_end_glfw() {
 
 
 void Window::_start_glew() {
-    // Set default rendering flags optimized for 2D rendering.
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_STENCIL_TEST);
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glewExperimental = GL_TRUE;
     if (glewInit() != GLEW_OK) {
         throw std::runtime_error("could not initialize glew");
@@ -197,6 +191,7 @@ void Window::_draw_loop() {
         if (_drawCallback) {
             _drawCallback(*this, *_context, period);
         }
+        _context->_end_frame();
 
         glfwSwapBuffers(_windowHandle);
 
@@ -0,0 +1,184 @@
+/*
+ * Checks the general, affine and rigid Mat4 inverses against a double
+ * precision inverse of the same matrices. The errors are relative to the
+ * largest element of the reference and bounded by the condition number of
+ * the matrix, as any float inverse loses that much precision.
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include <jelly/math.hpp>
+
+namespace {
+
+
+using namespace jelly;
+
+unsigned int failures = 0;
+
+std::mt19937 rng(1);
+
+
+float random_float(float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(rng);
+}
+
+
+Vec3 random_vec3(float lo, float hi) {
+    return Vec3(random_float(lo, hi), random_float(lo, hi), random_float(lo, hi));
+}
+
+
+Mat4 random_rotation() {
+    return Mat4::x_rotation(random_float(-3.2f, 3.2f))
+         * Mat4::y_rotation(random_float(-3.2f, 3.2f))
+         * Mat4::z_rotation(random_float(-3.2f, 3.2f));
+}
+
+
+Mat4d to_double(const Mat4& m) {
+    Mat4d result;
+    for (unsigned int i = 0; i < 16; ++i) {
+        result[i] = m[i];
+    }
+    return result;
+}
+
+
+double norm_inf(const Mat4d& m) {
+    double norm = 0.0;
+    for (unsigned int r = 0; r < 4; ++r) {
+        double row = 0.0;
+        for (unsigned int c = 0; c < 4; ++c) {
+            row += std::fabs(m(r, c));
+        }
+        norm = std::fmax(norm, row);
+    }
+    return norm;
+}
+
+
+/**
+ * Compares an inverse to the double precision reference, failing if its
+ * relative error exceeds slack times the condition number times the float
+ * epsilon.
+ *
+ * \returns
+ *     The relative error divided by the condition number.
+ */
+double check_inverse(const char* name, const Mat4& m, const Mat4& inv, double slack) {
+    Mat4d reference = inverse(to_double(m));
+    double largest = 0.0;
+    double error = 0.0;
+    for (unsigned int i = 0; i < 16; ++i) {
+        largest = std::fmax(largest, std::fabs(reference[i]));
+        error = std::fmax(error, std::fabs(inv[i] - reference[i]));
+    }
+    double condition = norm_inf(to_double(m)) * norm_inf(reference);
+    double relative = error / largest;
+    if (!(relative <= slack * condition * FLT_EPSILON)) {
+        failures += 1;
+        std::printf("FAIL %s: relative error %g with condition %g\n", name, relative, condition);
+    }
+    return relative / condition;
+}
+
+
+/**
+ * Runs an inverse on many random matrices of a kind and prints the worst
+ * error.
+ */
+template <typename Generate, typename Invert>
+void run(const char* name, Generate generate, Invert invert, double slack) {
+    double worst = 0.0;
+    for (unsigned int i = 0; i < 10000; ++i) {
+        Mat4 m = generate();
+        worst = std::fmax(worst, check_inverse(name, m, invert(m), slack));
+    }
+    std::printf("%-28s worst error / condition %.3g epsilon\n", name, worst / FLT_EPSILON);
+}
+
+
+Mat4 rigid() {
+    return Mat4::translation(random_vec3(-100.0f, 100.0f)) * random_rotation();
+}
+
+
+Mat4 uniform_scale() {
+    return rigid() * Mat4::scale(Vec3(random_float(0.1f, 10.0f)));
+}
+
+
+Mat4 non_uniform_scale() {
+    // Scales spanning 4 orders of magnitude between axes, for condition
+    // numbers up to about 1e5. The cofactor inverses lose precision faster
+    // than the condition number beyond that
+    Vec3 scale(random_float(1e-2f, 1e-1f), random_float(0.5f, 2.0f), random_float(10.0f, 100.0f));
+    return rigid() * Mat4::scale(scale) * random_rotation();
+}
+
+
+Mat4 near_singular() {
+    // An axis almost collapsed onto the plane of the others
+    Mat4 m = rigid() * Mat4::scale(random_vec3(0.5f, 2.0f));
+    float t = random_float(1e-5f, 1e-4f);
+    for (unsigned int r = 0; r < 3; ++r) {
+        m(r, 2) = m(r, 0) + m(r, 1) + t * m(r, 2);
+    }
+    return m;
+}
+
+
+Mat4 projection() {
+    return Mat4::perspective(random_float(0.5f, 2.0f), random_float(0.5f, 2.0f), 0.1f, 1000.0f)
+         * Mat4::look_at(random_vec3(-50.0f, 50.0f), random_vec3(-50.0f, 50.0f), Vec3(0.0f, 1.0f, 0.0f));
+}
+
+
+Mat4 general(const Mat4& m) {
+    return inverse(m);
+}
+
+
+Mat4 affine(const Mat4& m) {
+    return affine_inverse(m);
+}
+
+
+Mat4 rigid_only(const Mat4& m) {
+    return rigid_inverse(m);
+}
+
+
+}
+
+
+int main() {
+    // Also compare the SIMD kernels to the scalar templates
+    simd::set_verify(true);
+    std::printf("SIMD backend: %s\n", simd::backend());
+
+    run("inverse, rigid", rigid, general, 8.0);
+    run("inverse, uniform scale", uniform_scale, general, 8.0);
+    run("inverse, non-uniform scale", non_uniform_scale, general, 8.0);
+    run("inverse, near singular", near_singular, general, 8.0);
+    run("inverse, projection", projection, general, 8.0);
+
+    run("affine, rigid", rigid, affine, 8.0);
+    run("affine, uniform scale", uniform_scale, affine, 8.0);
+    run("affine, non-uniform scale", non_uniform_scale, affine, 8.0);
+    run("affine, near singular", near_singular, affine, 8.0);
+
+    run("rigid, rigid", rigid, rigid_only, 8.0);
+
+    if (simd::get_mismatch_count() > 0) {
+        std::printf("FAIL %u SIMD kernel mismatches\n", simd::get_mismatch_count());
+        failures += 1;
+    }
+
+    std::printf("%u failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}